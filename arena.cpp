@@ -1,80 +1,352 @@
 #include "arena.h"
+#include "disasm.h"
+#include "replay.h"
 #include <iostream>
+#include <algorithm>
 #include <cstring>
 #include <thread>
 #include <chrono>
+#include <cmath>
 
-Arena::Arena() {
-    std::memset(memory, 0, MEM_SIZE);
-    
-    // Create VMs sharing the SAME memory
-    p1 = new GenesisVM(memory, MEM_SIZE);
-    p2 = new GenesisVM(memory, MEM_SIZE);
+#define ARENA_TEMPLATE template <typename Word>
+#define ARENA BasicArena<Word>
+
+ARENA_TEMPLATE
+ARENA::BasicArena(size_t core) {
+    if (core < 2 || core > MAX_CORE) {
+        std::cerr << "Core size " << core << " does not fit " << 8 * sizeof(Word)
+                  << "-bit addresses, using " << DEFAULT_CORE << std::endl;
+        core = DEFAULT_CORE;
+    }
+    memory.assign(core, 0);
+    owner.assign(core, 0);
+    owned.assign(1, core);
 }
 
-Arena::~Arena() {
-    delete p1;
-    delete p2;
+ARENA_TEMPLATE
+void ARENA::set_cycle_budget(int n) {
+    cycle_budget = n;
+    for (auto& w : warriors) w->MAX_CYCLES = n;
 }
 
-void Arena::load_warriors(const std::vector<uint8_t>& dna1, const std::vector<uint8_t>& dna2) {
-    // Clear Battleground
-    std::memset(memory, 0, MEM_SIZE);
+ARENA_TEMPLATE
+void ARENA::set_decisive_share(double share) {
+    decisive_cells = NO_DECISIVE_SHARE;
+    if (share > 0) decisive_cells = std::max<size_t>(1, (size_t)std::ceil(share * memory.size()));
+}
+
+ARENA_TEMPLATE
+void ARENA::load_warriors(const std::vector<uint8_t>& dna1, const std::vector<uint8_t>& dna2) {
+    load_warriors(std::vector<std::vector<uint8_t>>{ dna1, dna2 });
+}
+
+ARENA_TEMPLATE
+void ARENA::load_warriors(const std::vector<std::vector<uint8_t>>& programs) {
+    size_t count = programs.size();
+    if (count > MAX_WARRIORS) {
+        std::cerr << count << " warriors is too many for one core, using the first " << MAX_WARRIORS << std::endl;
+        count = MAX_WARRIORS;
+    }
     
-    // Load P1 at 0
-    if (dna1.size() > 256) std::cerr << "P1 too fat!" << std::endl;
-    std::memcpy(memory, dna1.data(), std::min(dna1.size(), (size_t)256));
+    // Clear Battleground
+    std::fill(memory.begin(), memory.end(), 0);
+    std::fill(owner.begin(), owner.end(), 0);
+    owned.assign(count + 1, 0);
+    owned[0] = memory.size();
+    decided = 0;
     
-    // Load P2 at 512 (Halfway)
-    if (dna2.size() > 256) std::cerr << "P2 too fat!" << std::endl;
-    std::memcpy(memory + 512, dna2.data(), std::min(dna2.size(), (size_t)256));
+    // Create VMs sharing the SAME memory
+    while (warriors.size() < count) {
+        warriors.emplace_back(new WarriorVM(memory.data(), memory.size()));
+    }
+    warriors.resize(count);
+    if (count == 0) return;
     
-    // Reset Processors
-    p1->reset();
-    p1->ip = 0;
+    size_t slice = memory.size() / count;
+    for (size_t k = 0; k < count; ++k) {
+        size_t base = k * slice;
+        std::vector<uint8_t> code = programs[k];
+        if (code.size() > slice) {
+            std::cerr << "P" << k + 1 << " too fat!" << std::endl;
+            code.resize(slice);
+        }
+        
+        // Jumps were written as if the warrior sat at 0
+        for (const Instruction& insn : disassemble(code, WORD_BYTES)) {
+            if (insn.op != JMP && insn.op != JZ) continue;
+            std::vector<uint8_t> target;
+            emit_word(target, (uint32_t)((base + insn.imm) % memory.size()), WORD_BYTES);
+            for (int i = 0; i < WORD_BYTES && insn.addr + 1 + i < code.size(); ++i) {
+                code[insn.addr + 1 + i] = target[i];
+            }
+        }
+        std::memcpy(memory.data() + base, code.data(), code.size());
+        std::fill(owner.begin() + base, owner.begin() + base + code.size(), (uint8_t)(k + 1));
+        owned[0] -= code.size();
+        owned[k + 1] = code.size();
+        
+        // Reset Processors
+        warriors[k]->reset();
+        warriors[k]->MAX_CYCLES = cycle_budget;
+        warriors[k]->ip = (Word)base;
+        warriors[k]->owner_map = owner.data();
+        warriors[k]->owner_counts = owned.data();
+        warriors[k]->owner_id = (uint8_t)(k + 1);
+    }
+    died.assign(count, -1);
+    view.invalidate();
     
-    p2->reset();
-    p2->ip = 512;
+    attach_recorder();
+    if (recorder) {
+        std::vector<size_t> ips;
+        for (auto& w : warriors) ips.push_back(w->ip);
+        recorder->begin(WORD_BYTES, memory, owner, ips);
+    }
+}
+
+ARENA_TEMPLATE
+void ARENA::set_recorder(BattleRecorder* r) {
+    recorder = r;
+    attach_recorder();
+}
+
+ARENA_TEMPLATE
+void ARENA::attach_recorder() {
+    for (auto& w : warriors) {
+        w->store_hook = recorder ? &BattleRecorder::on_store : nullptr;
+        w->store_hook_context = recorder;
+    }
 }
 
-void Arena::run_battle(int cycles) {
+ARENA_TEMPLATE
+BattleResult ARENA::run_battle(int cycles, double fps, double speed) {
+    typedef std::chrono::steady_clock Clock;
+    if (fps <= 0) speed = 0; // Nothing to watch, so no reason to wait
     std::cout << "⚔️  THE ARENA ⚔️" << std::endl;
     std::cout << "P1 (Red) vs P2 (Blue)" << std::endl;
     
-    for (int i = 0; i < cycles; ++i) {
-        // Round Robin Execution
-        if (!p1->halted) p1->step();
-        if (!p2->halted) p2->step();
-        
-        if (i % 50 == 0) { // Render every 50 cycles
-            render();
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto frame_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0));
+    const auto start = Clock::now();
+    auto next_frame = start;
+    
+    int i = 0;
+    bool alive = true;
+    while (i < cycles && alive) {
+        // Run until the wall clock says stop: a throttled battle may not get
+        // ahead of `speed`, and the clock is only read every 256 rounds
+        int batch = 256;
+        auto now = Clock::now();
+        if (speed > 0) {
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            int allowed = (int)(elapsed * speed) + 1;
+            if (i >= allowed) {
+                auto due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(i / speed));
+                std::this_thread::sleep_until(fps > 0 ? std::min(due, next_frame) : due);
+                batch = 0;
+            } else {
+                batch = std::min(batch, allowed - i);
+            }
         }
+        for (int k = 0; k < batch && i < cycles && alive; ++k) alive = play_round(++i);
         
-        if (p1->halted && p2->halted) {
-             std::cout << "Both warriors died." << std::endl;
-             break;
+        if (fps > 0) {
+            now = Clock::now();
+            if (now >= next_frame) {
+                render();
+                next_frame = now + frame_period;
+            }
+        }
+    }
+    if (fps > 0) render(); // Final state
+    
+    BattleResult r = finish(i);
+    if (r.decided) std::cout << "P" << r.decided << " holds " << owned[r.decided] << " of " << memory.size() << " cells." << std::endl;
+    else if (!alive) std::cout << "All warriors died." << std::endl;
+    std::cout << "Rounds: " << r.cycles << " | Winner: " << (r.winner ? "P" + std::to_string(r.winner) : std::string("draw")) << std::endl;
+    for (size_t k = 0; k < warriors.size(); ++k) {
+        std::cout << "P" << k + 1 << " | Survived: " << r.survival[k] << " | Territory: " << r.territory[k] << std::endl;
+    }
+    return r;
+}
+
+ARENA_TEMPLATE
+bool ARENA::play_round(int round) {
+    return recorder ? play_round<true>(round) : play_round<false>(round);
+}
+
+// Recording gets its own copy of the loop (and simulate() of the loop
+// around it), so battles nobody records run exactly as before
+ARENA_TEMPLATE
+template <bool Record>
+bool ARENA::play_round(int round) {
+    // Round Robin Execution
+    bool alive = false;
+    for (size_t k = 0; k < warriors.size(); ++k) {
+        WarriorVM& w = *warriors[k];
+        if (!w.halted) {
+            w.step();
+            if (w.halted) died[k] = round;
+            if (Record) recorder->stepped(k, w.ip, w.halted);
         }
+        alive |= !w.halted;
+    }
+    if (Record) recorder->end_round(round, memory, owner);
+    if (decisive_cells != NO_DECISIVE_SHARE && decisive()) return false;
+    return alive;
+}
+
+// Checked once a round, so the share has to hold until everyone has moved.
+// Kept out of play_round so the loop around it stays small enough to inline.
+ARENA_TEMPLATE
+bool ARENA::decisive() {
+    for (size_t k = 0; k < warriors.size(); ++k) {
+        if (!warriors[k]->halted && owned[k + 1] >= decisive_cells) decided = (int)k + 1;
+    }
+    return decided != 0;
+}
+
+ARENA_TEMPLATE
+BattleResult ARENA::simulate(int cycles) {
+    return finish(recorder ? play_rounds<true>(cycles) : play_rounds<false>(cycles));
+}
+
+ARENA_TEMPLATE
+template <bool Record>
+int ARENA::play_rounds(int cycles) {
+    int i = 0;
+    while (i < cycles) {
+        if (!play_round<Record>(++i)) break;
+    }
+    return i;
+}
+
+ARENA_TEMPLATE
+BattleResult ARENA::finish(int cycles) {
+    BattleResult r = judge(cycles);
+    if (recorder) recorder->finish(r);
+    return r;
+}
+
+// The warrior that lasted longest wins, then the one owning more cells.
+// A tie at the top is a draw.
+ARENA_TEMPLATE
+BattleResult ARENA::judge(int cycles) const {
+    BattleResult r;
+    r.cycles = cycles;
+    r.winner = 0;
+    r.decided = decided;
+    size_t n = warriors.size();
+    if (n == 0) return r;
+    
+    for (size_t k = 0; k < n; ++k) {
+        r.survival.push_back(died[k] < 0 ? cycles : died[k]);
+        r.territory.push_back((int)owned[k + 1]);
     }
+    
+    auto key = [&](size_t k) { return std::make_pair(r.survival[k], r.territory[k]); };
+    size_t best = 0;
+    bool tied = false;
+    for (size_t k = 1; k < n; ++k) {
+        if (key(k) > key(best)) { best = k; tied = false; }
+        else if (key(k) == key(best)) tied = true;
+    }
+    if (!tied) r.winner = (int)best + 1;
+    return r;
+}
+
+// Cell codes for the renderer: kind in the high bits, detail below
+static const uint32_t CELL_EMPTY = 0;
+static const uint32_t CELL_DATA = 1u << 16;      // | byte
+static const uint32_t CELL_CURSOR = 2u << 16;    // | warrior
+static const uint32_t CELL_COLLISION = 3u << 16;
+static const size_t ROW_CELLS = 64;
+
+ARENA_TEMPLATE
+void ARENA::render() {
+    std::vector<size_t> ips;
+    for (auto& w : warriors) ips.push_back(w->ip);
+    view.draw(memory, ips);
 }
 
-void Arena::render() {
-    // Clear screen (ANSI)
-    std::cout << "\033[2J\033[H";
+void CoreRenderer::draw(const std::vector<uint8_t>& memory, const std::vector<size_t>& ips, long round) {
+    // A big core would scroll for pages; the first 4 KB tells the story
+    size_t shown = std::min(memory.size(), (size_t)4096);
+    
+    next_screen.resize(shown);
+    for (size_t i = 0; i < shown; ++i) next_screen[i] = memory[i] ? (CELL_DATA | memory[i]) : CELL_EMPTY;
+    for (size_t k = 0; k < ips.size(); ++k) {
+        size_t at = ips[k];
+        if (at >= shown) continue;
+        uint32_t& cell = next_screen[at];
+        if ((cell & 0xFFFF0000u) == CELL_CURSOR || cell == CELL_COLLISION) cell = CELL_COLLISION;
+        else cell = CELL_CURSOR | (uint32_t)k;
+    }
     
-    std::cout << "Cycle: P1 IP=" << (int)p1->ip << " | P2 IP=" << (int)p2->ip << std::endl;
+    // The whole frame goes out in one write
+    frame.clear();
+    bool full = screen.size() != shown;
+    if (full) {
+        frame += "\033[2J";
+        screen.assign(shown, ~0u);
+    }
+    frame += "\033[H\033[2KCycle:";
+    if (round >= 0) frame += " " + std::to_string(round) + " |";
+    for (size_t k = 0; k < ips.size(); ++k) {
+        frame += (k ? " | P" : " P") + std::to_string(k + 1) + " IP=" + std::to_string(ips[k]);
+    }
     
-    for (int i = 0; i < MEM_SIZE; ++i) {
-        // Color logic
-        bool is_p1_ip = (i == p1->ip);
-        bool is_p2_ip = (i == p2->ip);
+    // P1 red, P2 blue, then the other ANSI colours
+    static const char* colors[] = { "\033[1;31m", "\033[1;34m", "\033[1;33m", "\033[1;36m", "\033[1;35m", "\033[1;37m" };
+    const char* color = nullptr; // Last colour emitted
+    size_t cursor = ~(size_t)0;  // Cell the terminal cursor sits on
+    for (size_t i = 0; i < shown; ++i) {
+        uint32_t cell = next_screen[i];
+        if (cell == screen[i]) continue;
+        screen[i] = cell;
+        
+        if (cursor != i) {
+            frame += "\033[" + std::to_string(i / ROW_CELLS + 2) + ";" + std::to_string((i % ROW_CELLS) * 2 + 1) + "H";
+        }
         
-        if (is_p1_ip && is_p2_ip) std::cout << "\033[1;45mXX\033[0m"; // Collision
-        else if (is_p1_ip) std::cout << "\033[1;31m[]\033[0m";       // P1 Cursor
-        else if (is_p2_ip) std::cout << "\033[1;34m[]\033[0m";       // P2 Cursor
-        else if (memory[i] != 0) std::cout << "\033[1;32m" << (memory[i] > 32 && memory[i] < 126 ? (char)memory[i] : '.') << "\033[0m "; 
-        else std::cout << ". ";
+        const char* want;
+        char text[2] = { '.', ' ' };
+        if (cell == CELL_COLLISION) { want = "\033[1;45m"; text[0] = text[1] = 'X'; } // Collision
+        else if ((cell & 0xFFFF0000u) == CELL_CURSOR) { want = colors[(cell & 0xFFFF) % 6]; text[0] = '['; text[1] = ']'; }
+        else if (cell != CELL_EMPTY) {
+            uint8_t byte = cell & 0xFF;
+            want = "\033[1;32m";
+            text[0] = (byte > 32 && byte < 126) ? (char)byte : '.';
+        } else want = "\033[0m";
         
-        if ((i + 1) % 64 == 0) std::cout << std::endl;
+        if (want != color) { frame += want; color = want; }
+        frame.append(text, 2);
+        cursor = i + 1;
+        if (cursor % ROW_CELLS == 0) cursor = ~(size_t)0; // Next row needs a move
+    }
+    frame += "\033[0m\033[" + std::to_string((shown + ROW_CELLS - 1) / ROW_CELLS + 2) + ";1H";
+    
+    std::cout.write(frame.data(), frame.size());
+    std::cout.flush();
+}
+
+std::vector<uint8_t> builtin_warrior(const std::string& type, int word_bytes) {
+    std::vector<uint8_t> code;
+    if (type == "bomber") {
+        code = { LDI, 0 }; emit_word(code, 0, word_bytes);
+        code.insert(code.end(), { LDI, 1 }); emit_word(code, 20, word_bytes);
+        size_t loop = code.size();
+        code.insert(code.end(), { ST, 1, 0, INC, 1, JMP }); emit_word(code, (uint32_t)loop, word_bytes);
+    } else if (type == "runner") {
+        code = { JMP }; emit_word(code, 0, word_bytes);
+    } else if (type == "replicator") {
+        code = { LDI, 0 }; emit_word(code, 0, word_bytes);
+        code.insert(code.end(), { LDI, 1 }); emit_word(code, 64, word_bytes);
+        size_t loop = code.size();
+        code.insert(code.end(), { LD, 3, 0, ST, 1, 3, INC, 0, INC, 1, JMP }); emit_word(code, (uint32_t)loop, word_bytes);
     }
+    return code;
 }
+
+template class BasicArena<uint8_t>;
+template class BasicArena<uint16_t>;
+template class BasicArena<uint32_t>;
@@ -3,23 +3,106 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <cstdint>
 #include "vm.h"
 
-class Arena {
+// Outcome of one headless battle
+struct BattleResult {
+    int winner;                 // 1-based warrior number, 0 for a draw
+    int cycles;                 // Rounds played before the battle ended
+    std::vector<int> survival;  // Rounds each warrior stayed alive
+    std::vector<int> territory; // Cells each warrior wrote last (its own code counts)
+    int decided = 0;            // Warrior whose decisive share ended the battle early, or 0
+};
+
+class BattleRecorder;
+
+// Terminal view of a core: memory bytes plus one cursor per warrior. It
+// remembers the last frame and only sends the cells that changed.
+class CoreRenderer {
 public:
-    static const size_t MEM_SIZE = 1024;
-    uint8_t memory[MEM_SIZE];
+    // `round` < 0 leaves the round number out of the status line
+    void draw(const std::vector<uint8_t>& memory, const std::vector<size_t>& ips, long round = -1);
+    void invalidate() { screen.clear(); } // Next frame is a full redraw
+
+private:
+    // What each visible cell showed in the last frame; empty means nothing
+    // has been drawn yet
+    std::vector<uint32_t> screen;
+    std::vector<uint32_t> next_screen;
+    std::string frame;
+};
+
+// Shared core where warriors fight. Word is the address width: ip,
+// registers and JMP/JZ/LDI immediates are that wide, so 8-bit warriors live
+// in at most 256 bytes, 16-bit ones in 64 KB and 32-bit ones anywhere.
+// Warriors are spread evenly over the core, and their JMP/JZ targets are
+// relocated to where they were loaded. Every cell remembers which warrior
+// wrote it last, and each warrior's count of cells is kept up to date as
+// it goes, so territory never needs a scan of the core.
+template <typename Word>
+class BasicArena {
+public:
+    typedef BasicVM<0, 4, Word> WarriorVM;
+    static constexpr int WORD_BYTES = sizeof(Word);
+    static constexpr size_t MAX_CORE = sizeof(Word) >= 4 ? (size_t)1 << 30 : (size_t)1 << (8 * sizeof(Word));
+    static constexpr size_t DEFAULT_CORE = sizeof(Word) == 1 ? 256 : 1024;
+    static constexpr size_t MAX_WARRIORS = 255; // Owner ids are one byte
     
-    GenesisVM* p1;
-    GenesisVM* p2;
+    std::vector<uint8_t> memory;
+    std::vector<std::unique_ptr<WarriorVM>> warriors; // P1, P2, ...
     
-    Arena();
-    ~Arena();
+    explicit BasicArena(size_t core_size = DEFAULT_CORE);
     
+    size_t core_size() const { return memory.size(); }
+    void set_cycle_budget(int n); // Instructions each warrior may execute (default 1000)
+    // End the battle once a living warrior owns this fraction of the core
+    // (0 = never). Above 0.5 that warrior is then the winner.
+    void set_decisive_share(double share);
     void load_warriors(const std::vector<uint8_t>& dna1, const std::vector<uint8_t>& dna2);
-    void run_battle(int cycles);
+    void load_warriors(const std::vector<std::vector<uint8_t>>& programs);
+    // Watch a battle. The simulation runs at `speed` rounds per second
+    // (0 = as fast as it can) and a frame is drawn `fps` times per second of
+    // wall clock, whatever the speed. fps 0 turns rendering off and runs
+    // at full speed.
+    BattleResult run_battle(int cycles, double fps = 20, double speed = 1000);
+    BattleResult simulate(int cycles); // Same battle, no rendering or sleeping
     void render();
+    // Log the battles started by later load_warriors() calls (replay.h);
+    // nullptr stops. The recorder must outlive the battles it records.
+    void set_recorder(BattleRecorder* r);
+
+    // Warrior number (1-based) that wrote each cell last, 0 = nobody
+    const std::vector<uint8_t>& ownership() const { return owner; }
+    size_t territory(size_t k) const { return owned[k + 1]; } // Cells warrior k owns
+
+private:
+    int cycle_budget = 1000;
+    std::vector<int> died; // Round each warrior halted in, -1 while alive
+    std::vector<uint8_t> owner;
+    std::vector<size_t> owned;  // Cells per owner id; owned[0] is unowned
+    static constexpr size_t NO_DECISIVE_SHARE = ~(size_t)0;
+    size_t decisive_cells = NO_DECISIVE_SHARE;
+    int decided = 0;
+    BattleRecorder* recorder = nullptr;
+    bool play_round(int round); // One instruction each; false once all are dead
+    template <bool Record> bool play_round(int round);
+    template <bool Record> int play_rounds(int cycles); // Rounds played
+    bool decisive(); // Sets `decided` if a living warrior holds decisive_cells
+    BattleResult judge(int cycles) const;
+    BattleResult finish(int cycles); // judge(), and close the recording
+    void attach_recorder();
+    CoreRenderer view;
 };
 
+typedef BasicArena<uint8_t> Arena8;
+typedef BasicArena<uint16_t> Arena;   // Default: 1 KB core, room to grow to 64 KB
+typedef BasicArena<uint32_t> Arena32;
+
+// Built-in warriors ("bomber", "runner", "replicator"), assembled for 1, 2 or
+// 4 byte addresses. Jump targets assume the warrior sits at 0; the Arena
+// relocates them. Unknown names give an empty program.
+std::vector<uint8_t> builtin_warrior(const std::string& type, int word_bytes);
+
 #endif
@@ -0,0 +1,236 @@
+#include "batch_vm.h"
+#include <iostream>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// --- Row: one byte per lane, 32 lanes ---
+// AVX2 uses one register, SSE2 two halves, anything else a plain loop.
+namespace {
+
+#if defined(__AVX2__)
+
+struct Row {
+    __m256i v;
+    static Row load(const uint8_t* p) { return { _mm256_load_si256((const __m256i*)p) }; }
+    static Row splat(uint8_t x) { return { _mm256_set1_epi8((char)x) }; }
+    void store(uint8_t* p) const { _mm256_store_si256((__m256i*)p, v); }
+    Row operator+(Row o) const { return { _mm256_add_epi8(v, o.v) }; }
+    Row operator-(Row o) const { return { _mm256_sub_epi8(v, o.v) }; }
+    Row operator&(Row o) const { return { _mm256_and_si256(v, o.v) }; }
+    Row operator|(Row o) const { return { _mm256_or_si256(v, o.v) }; }
+    Row eq(Row o) const { return { _mm256_cmpeq_epi8(v, o.v) }; }
+    Row andnot(Row o) const { return { _mm256_andnot_si256(o.v, v) }; } // this & ~o
+    static Row select(Row m, Row a, Row b) { return { _mm256_blendv_epi8(b.v, a.v, m.v) }; }
+    uint32_t bits() const { return (uint32_t)_mm256_movemask_epi8(v); }
+};
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+struct Row {
+    __m128i lo, hi;
+    static Row load(const uint8_t* p) { return { _mm_load_si128((const __m128i*)p), _mm_load_si128((const __m128i*)(p + 16)) }; }
+    static Row splat(uint8_t x) { __m128i s = _mm_set1_epi8((char)x); return { s, s }; }
+    void store(uint8_t* p) const { _mm_store_si128((__m128i*)p, lo); _mm_store_si128((__m128i*)(p + 16), hi); }
+    Row operator+(Row o) const { return { _mm_add_epi8(lo, o.lo), _mm_add_epi8(hi, o.hi) }; }
+    Row operator-(Row o) const { return { _mm_sub_epi8(lo, o.lo), _mm_sub_epi8(hi, o.hi) }; }
+    Row operator&(Row o) const { return { _mm_and_si128(lo, o.lo), _mm_and_si128(hi, o.hi) }; }
+    Row operator|(Row o) const { return { _mm_or_si128(lo, o.lo), _mm_or_si128(hi, o.hi) }; }
+    Row eq(Row o) const { return { _mm_cmpeq_epi8(lo, o.lo), _mm_cmpeq_epi8(hi, o.hi) }; }
+    Row andnot(Row o) const { return { _mm_andnot_si128(o.lo, lo), _mm_andnot_si128(o.hi, hi) }; }
+    static Row select(Row m, Row a, Row b) {
+        return { _mm_or_si128(_mm_and_si128(m.lo, a.lo), _mm_andnot_si128(m.lo, b.lo)),
+                 _mm_or_si128(_mm_and_si128(m.hi, a.hi), _mm_andnot_si128(m.hi, b.hi)) };
+    }
+    uint32_t bits() const { return (uint32_t)_mm_movemask_epi8(lo) | ((uint32_t)_mm_movemask_epi8(hi) << 16); }
+};
+
+#else
+
+struct Row {
+    uint8_t b[BatchVM::LANES];
+    template <typename F> static Row map(F f) { Row r; for (int i = 0; i < BatchVM::LANES; ++i) r.b[i] = f(i); return r; }
+    static Row load(const uint8_t* p) { return map([&](int i) { return p[i]; }); }
+    static Row splat(uint8_t x) { return map([&](int) { return x; }); }
+    void store(uint8_t* p) const { std::memcpy(p, b, sizeof(b)); }
+    Row operator+(Row o) const { return map([&](int i) { return (uint8_t)(b[i] + o.b[i]); }); }
+    Row operator-(Row o) const { return map([&](int i) { return (uint8_t)(b[i] - o.b[i]); }); }
+    Row operator&(Row o) const { return map([&](int i) { return (uint8_t)(b[i] & o.b[i]); }); }
+    Row operator|(Row o) const { return map([&](int i) { return (uint8_t)(b[i] | o.b[i]); }); }
+    Row eq(Row o) const { return map([&](int i) { return (uint8_t)(b[i] == o.b[i] ? 0xFF : 0); }); }
+    Row andnot(Row o) const { return map([&](int i) { return (uint8_t)(b[i] & ~o.b[i]); }); }
+    static Row select(Row m, Row a, Row c) { return map([&](int i) { return m.b[i] ? a.b[i] : c.b[i]; }); }
+    uint32_t bits() const { uint32_t m = 0; for (int i = 0; i < BatchVM::LANES; ++i) if (b[i]) m |= 1u << i; return m; }
+};
+
+#endif
+
+// Bytes taken by the instruction starting with `op` (opcode included)
+inline int insn_length(uint8_t op) {
+    switch (op) {
+        case INC: case DEC: case JMP: case JZ: case IO: return 2;
+        case ADD: case SUB: case MOV: case LDI: case LD: case ST: return 3;
+        default: return 1;
+    }
+}
+
+inline int lowest_lane(uint32_t m) {
+#if defined(__GNUC__)
+    return __builtin_ctz(m);
+#else
+    int i = 0;
+    while (!(m & 1u)) { m >>= 1; ++i; }
+    return i;
+#endif
+}
+
+} // namespace
+
+BatchVM::BatchVM() {
+    reset(0);
+}
+
+void BatchVM::reset(int lanes) {
+    lane_count = lanes;
+    std::memset(memory, 0, sizeof(memory));
+    std::memset(registers, 0, sizeof(registers));
+    std::memset(ip, 0, sizeof(ip));
+    for (int i = 0; i < LANES; ++i) {
+        stopped[i] = (i < lanes) ? 0x00 : 0xFF;
+        instructions_executed[i] = 0;
+    }
+    cycle = 0;
+}
+
+void BatchVM::load_program(int lane, GenomeView program) {
+    if (program.size() > (size_t)MEM_SIZE) {
+        std::cerr << "Error: DNA too long for cell memory." << std::endl;
+        return;
+    }
+    for (size_t i = 0; i < program.size(); ++i) {
+        memory[i][lane] = program[i];
+    }
+}
+
+bool BatchVM::step() {
+    Row done = Row::load(stopped);
+    uint32_t pending = ~done.bits();
+    if (pending == 0) return false;
+
+    if (cycle >= MAX_CYCLES) {
+        for (int i = 0; i < LANES; ++i) stopped[i] = 0xFF;
+        return false;
+    }
+
+    Row ip_row = Row::load(ip);
+    Row halting = Row::splat(0);
+
+    while (pending) {
+        // The lowest pending lane leads; every lane with the same ip and the
+        // same instruction bytes runs with it.
+        int lead = lowest_lane(pending);
+        uint8_t pc = ip[lead];
+        uint8_t op = memory[pc][lead];
+        int len = insn_length(op);
+
+        Row group = ip_row.eq(Row::splat(pc)).andnot(done);
+        for (int k = 0; k < len; ++k) {
+            uint8_t at = (uint8_t)(pc + k);
+            group = group & Row::load(memory[at]).eq(Row::splat(memory[at][lead]));
+        }
+        uint32_t lanes = group.bits();
+
+        uint8_t a = memory[(uint8_t)(pc + 1)][lead];
+        uint8_t b = memory[(uint8_t)(pc + 2)][lead];
+        Row next = Row::splat((uint8_t)(pc + len));
+
+        switch (op) {
+            case INC: {
+                Row r = Row::load(registers[a % 4]);
+                Row::select(group, r + Row::splat(1), r).store(registers[a % 4]);
+                break;
+            }
+            case DEC: {
+                Row r = Row::load(registers[a % 4]);
+                Row::select(group, r - Row::splat(1), r).store(registers[a % 4]);
+                break;
+            }
+            case ADD: {
+                Row d = Row::load(registers[a % 4]);
+                Row s = Row::load(registers[b % 4]);
+                Row::select(group, d + s, d).store(registers[a % 4]);
+                break;
+            }
+            case SUB: {
+                Row d = Row::load(registers[a % 4]);
+                Row s = Row::load(registers[b % 4]);
+                Row::select(group, d - s, d).store(registers[a % 4]);
+                break;
+            }
+            case MOV: {
+                Row d = Row::load(registers[a % 4]);
+                Row s = Row::load(registers[b % 4]);
+                Row::select(group, s, d).store(registers[a % 4]);
+                break;
+            }
+            case LDI: {
+                Row d = Row::load(registers[a % 4]);
+                Row::select(group, Row::splat(b), d).store(registers[a % 4]);
+                break;
+            }
+            case JMP:
+                next = Row::splat(a);
+                break;
+            case JZ: {
+                Row zero = Row::load(registers[0]).eq(Row::splat(0));
+                next = Row::select(zero, Row::splat(a), next);
+                break;
+            }
+            case LD: {
+                // Addresses differ per lane, so this one is a scalar gather
+                for (uint32_t m = lanes; m; m &= m - 1) {
+                    int l = lowest_lane(m);
+                    uint8_t addr = registers[b % 4][l];
+                    registers[a % 4][l] = memory[addr][l];
+                }
+                break;
+            }
+            case ST: {
+                for (uint32_t m = lanes; m; m &= m - 1) {
+                    int l = lowest_lane(m);
+                    uint8_t addr = registers[a % 4][l];
+                    memory[addr][l] = registers[b % 4][l];
+                }
+                break;
+            }
+            case HLT:
+                halting = halting | group;
+                break;
+            default: // NOP, IO and unknown opcodes only move ip
+                break;
+        }
+
+        ip_row = Row::select(group, next, ip_row);
+        done = done | group; // Executed this step
+        pending &= ~lanes;
+    }
+
+    ip_row.store(ip);
+    cycle++;
+
+    uint32_t halted_now = halting.bits();
+    for (uint32_t m = halted_now; m; m &= m - 1) {
+        instructions_executed[lowest_lane(m)] = cycle;
+    }
+    (Row::load(stopped) | halting).store(stopped);
+    return true;
+}
+
+void BatchVM::run() {
+    while (step()) {}
+    for (int i = 0; i < lane_count; ++i) {
+        if (instructions_executed[i] == 0) instructions_executed[i] = cycle;
+    }
+}
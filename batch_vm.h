@@ -0,0 +1,41 @@
+#ifndef BATCH_VM_H
+#define BATCH_VM_H
+
+#include <vector>
+#include <cstdint>
+#include "vm.h"
+
+// Lockstep interpreter for up to 32 cells of 256 bytes each.
+// State is stored as structure-of-arrays (row[x][lane]) so one SIMD register
+// holds the same register / memory byte of every lane. Each step, lanes that
+// sit on identical instruction bytes execute together; lanes that diverged
+// (different ip after a JZ, or code rewritten by ST) form their own group
+// in the same step. Halted and unused lanes are masked out. Lanes pay off
+// when they share code: the test cases of related organisms, not of one.
+//
+// Lane results match GenesisVM with a 256-byte cell. IO output is not
+// captured: batch runs are meant for register-scored modes (math, consciousness).
+struct BatchVM {
+    static constexpr int LANES = 32;
+    static constexpr int MEM_SIZE = 256;
+    const int MAX_CYCLES = 1000;
+
+    alignas(32) uint8_t memory[MEM_SIZE][LANES];
+    alignas(32) uint8_t registers[4][LANES];
+    alignas(32) uint8_t ip[LANES];
+    alignas(32) uint8_t stopped[LANES]; // 0xFF once a lane halted (or is unused)
+    int instructions_executed[LANES];
+    int cycle;
+
+    BatchVM();
+
+    void reset(int lanes);                                      // Zero state, enable lanes [0, lanes)
+    void load_program(int lane, GenomeView program);
+    bool step();                                                // False once every lane stopped
+    void run();
+
+private:
+    int lane_count;
+};
+
+#endif
@@ -0,0 +1,307 @@
+// Genesis benchmark suite. Prints one JSON object per line:
+//   {"bench":"vm.alu","variant":"interp","value":812.3,"unit":"Minsn/s","seconds":0.31}
+// so runs from two releases can be diffed or loaded into anything.
+//
+// Usage: genesis_bench [--seconds S] [--threads N] [filter ...]
+// Filters are substrings of "bench/variant"; with none, everything runs.
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <algorithm>
+#include "darwin.h"
+#include "fitness.h"
+#include "bio.h"
+#include "arena.h"
+
+namespace {
+
+double min_seconds = 0.3; // Per case
+unsigned evolve_threads = 1;
+std::vector<std::string> filters;
+
+bool wanted(const std::string& bench, const std::string& variant) {
+    if (filters.empty()) return true;
+    std::string name = bench + "/" + variant;
+    for (const std::string& f : filters) {
+        if (name.find(f) != std::string::npos) return true;
+    }
+    return false;
+}
+
+void report(const std::string& bench, const std::string& variant, double value, const char* unit, double seconds) {
+    printf("{\"bench\":\"%s\",\"variant\":\"%s\",\"value\":%.6g,\"unit\":\"%s\",\"seconds\":%.3f}\n",
+           bench.c_str(), variant.c_str(), value, unit, seconds);
+    fflush(stdout);
+}
+
+// Calls body() until min_seconds have passed; body returns the work it did.
+// One untimed call first warms caches and lazily built tables.
+template <typename F>
+void measure(const std::string& bench, const std::string& variant, const char* unit, double scale, F body) {
+    if (!wanted(bench, variant)) return;
+    body();
+    double work = 0, seconds = 0;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        work += (double)body();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < min_seconds);
+    report(bench, variant, work / seconds / scale, unit, seconds);
+}
+
+std::vector<std::vector<uint8_t>> random_genomes(size_t count, size_t length, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::vector<uint8_t>> genomes(count, std::vector<uint8_t>(length));
+    for (auto& g : genomes) for (auto& b : g) b = (uint8_t)rng();
+    return genomes;
+}
+
+// --- VM: instructions per second for a few opcode mixes ---
+
+struct Mix {
+    const char* name;
+    std::vector<uint8_t> code;
+};
+
+std::vector<Mix> opcode_mixes() {
+    return {
+        // 0: LDI r0,1 | 3: INC r1 ; ADD r0,r1 ; SUB r2,r0 ; MOV r3,r2 ; JMP 3
+        { "alu", { LDI, 0, 1, INC, 1, ADD, 0, 1, SUB, 2, 0, MOV, 3, 2, JMP, 3 } },
+        // 0: LDI r0,3 | 3: DEC r0 ; JZ 9 ; JMP 3 | 9: JMP 0
+        { "branch", { LDI, 0, 3, DEC, 0, JZ, 9, JMP, 3, JMP, 0 } },
+        // 0: LDI r1,200 | 3: LD r2,[r1] ; ST [r1],r2 ; LD r3,[r1] ; ADD r0,r3 ; JMP 3
+        { "memory", { LDI, 1, 200, LD, 2, 1, ST, 1, 2, LD, 3, 1, ADD, 0, 3, JMP, 3 } },
+        // 0: LDI r0,65 | 3: IO 0 ; INC r0 ; IO 1 ; JMP 3
+        { "io", { LDI, 0, 65, IO, 0, INC, 0, IO, 1, JMP, 3 } },
+    };
+}
+
+void bench_vm() {
+    const int budget = 1000000;
+    CellVM vm;
+    JitProgram jit;
+
+    for (const Mix& mix : opcode_mixes()) {
+        std::string bench = std::string("vm.") + mix.name;
+        auto load = [&]() {
+            vm.reset();
+            vm.load_program(mix.code);
+            vm.MAX_CYCLES = budget;
+            vm.detect_cycles = false;
+        };
+        measure(bench, "interp", "Minsn/s", 1e6, [&]() {
+            load();
+            vm.run();
+            return vm.instructions_executed;
+        });
+        if (JitProgram::supported()) {
+            load();
+            jit.compile(vm);
+            measure(bench, "jit", "Minsn/s", 1e6, [&]() {
+                load();
+                jit.run(vm);
+                return vm.instructions_executed;
+            });
+        }
+    }
+
+    // What evolution actually runs: random 32-byte genomes, default budget.
+    // Only executed instructions count, not the cycles loop detection skips
+    auto genomes = random_genomes(1024, 32, 1);
+    for (bool detect : { false, true }) {
+        measure("vm.random", detect ? "interp+loops" : "interp", "Minsn/s", 1e6, [&]() {
+            long long executed = 0;
+            for (const auto& g : genomes) {
+                vm.reset();
+                vm.load_program(g);
+                vm.MAX_CYCLES = 1000;
+                vm.detect_cycles = detect;
+                vm.run();
+                executed += vm.instructions_executed;
+            }
+            return executed;
+        });
+    }
+
+    // One survival radiation trial: replay the 50-step prefix, or restore it
+    auto survivors = random_genomes(256, 128, 5);
+    CellVM::Snapshot snapshot;
+    for (bool restore : { false, true }) {
+        measure("vm.survival-trial", restore ? "restore" : "replay", "trials/s", 1, [&]() {
+            for (const auto& g : survivors) {
+                vm.MAX_CYCLES = 1000;
+                vm.detect_cycles = true;
+                if (restore) {
+                    vm.reset();
+                    vm.load_program(g);
+                    for (int i = 0; i < 50; ++i) vm.step();
+                    vm.take_snapshot(snapshot);
+                }
+                for (int t = 0; t < 8; ++t) {
+                    if (restore) {
+                        if (t) vm.restore(snapshot);
+                    } else {
+                        vm.reset();
+                        vm.load_program(g);
+                        for (int i = 0; i < 50; ++i) vm.step();
+                    }
+                    vm.poke(t * 13, (uint8_t)t);
+                    vm.run();
+                }
+            }
+            return survivors.size() * 8;
+        });
+    }
+}
+
+// --- Fitness: score_dna evaluations per second for each mode and engine ---
+
+void bench_fitness() {
+    WorkerState ws;
+    std::string target = "Hi";
+
+    for (const char* mode : { "string", "math", "survival", "consciousness" }) {
+        const FitnessMode& fm = fitness_mode(mode);
+        auto genomes = random_genomes(512, std::string(mode) == "survival" ? 128 : 32, 2);
+        std::string bench = std::string("fitness.") + mode;
+
+        // Through score_genome, as DarwinEngine::score_dna scores them
+        auto run = [&](const std::vector<std::vector<uint8_t>>& set, bool use_jit) {
+            ScoreOptions options;
+            options.jit = use_jit;
+            uint32_t seed = 0;
+            for (const auto& g : set) score_genome(fm, options, g, ws, target, seed++);
+            return set.size();
+        };
+
+        measure(bench, "interp", "evals/s", 1, [&]() { return run(genomes, false); });
+        if (fm.deterministic && JitProgram::supported()) {
+            // Every pass changes a byte of each genome, so all of them compile
+            auto fresh = genomes;
+            uint8_t pass = 0;
+            measure(bench, "jit", "evals/s", 1, [&]() {
+                ++pass;
+                for (auto& g : fresh) g.back() = pass;
+                return run(fresh, true);
+            });
+        }
+        if (fm.score_batch) {
+            // The whole set as one slice, as DarwinEngine hands it over
+            std::vector<GenomeView> views(genomes.begin(), genomes.end());
+            std::vector<double> scores(views.size());
+            measure(bench, "batch", "evals/s", 1, [&]() {
+                fm.score_batch(views.data(), views.size(), ws.batch, scores.data());
+                return genomes.size();
+            });
+        }
+    }
+}
+
+// --- Evolution: whole generations per second ---
+
+void bench_evolve() {
+    std::string threads = "threads=" + std::to_string(evolve_threads);
+    for (const char* mode : { "string", "math", "survival", "consciousness" }) {
+        bool survival = std::string(mode) == "survival";
+        // Only modes with several test cases prune, batch or compile
+        bool cases = std::string(mode) == "math" || std::string(mode) == "consciousness";
+        // Plain, --prune, --batch, --jit, and --jit against plain with --cache 0
+        for (int variant = 0; variant < 6; ++variant) {
+            bool prune = variant == 1, batch = variant == 2, jit = variant == 3 || variant == 5;
+            bool uncached = variant >= 4;
+            if ((prune || batch || variant >= 3) && !cases) continue;
+            if (jit && !JitProgram::supported()) continue;
+            DarwinEngine engine(1000, survival ? 128 : 32, 3);
+            engine.set_mode(mode);
+            engine.set_target("Hi");
+            engine.set_threads(evolve_threads);
+            engine.set_pruning(prune);
+            engine.set_batch_eval(batch);
+            engine.set_jit(jit);
+            if (uncached) engine.set_cache_capacity(0);
+            engine.set_quiet(true);
+            std::string variant_name = threads + (prune ? "+prune" : batch ? "+batch" : jit ? "+jit" : "") +
+                                       (uncached ? "+nocache" : "");
+            measure(std::string("evolve.") + mode, variant_name, "gens/s", 1, [&]() {
+                // Stops early once solved; count what actually ran
+                uint64_t before = engine.get_generation();
+                engine.evolve(10);
+                return engine.get_generation() - before;
+            });
+        }
+    }
+}
+
+// --- BioCompiler: MB/s of input ---
+
+void bench_bio() {
+    auto data = random_genomes(1, 4 << 20, 4)[0];
+    std::string dna = BioCompiler::encode(data);
+
+    std::string fasta = ">bench\n";
+    for (size_t i = 0; i < dna.size(); i += 60) fasta += dna.substr(i, 60) + "\n";
+
+    measure("bio.encode", "memory", "MB/s", 1e6, [&]() { return BioCompiler::encode(data).size() / 4; });
+    measure("bio.decode", "memory", "MB/s", 1e6, [&]() { BioCompiler::decode(dna); return dna.size(); });
+    measure("bio.decode", "fasta-stream", "MB/s", 1e6, [&]() {
+        size_t bytes = 0;
+        DnaDecoder decoder([&](const uint8_t*, size_t n) { bytes += n; });
+        decoder.feed(fasta.data(), fasta.size());
+        decoder.finish();
+        return fasta.size();
+    });
+}
+
+// --- Arena: warrior instructions per second ---
+
+template <typename Word>
+void bench_arena(const std::string& variant, size_t core, int count) {
+    static const char* kinds[] = { "bomber", "replicator", "runner" };
+    std::vector<std::vector<uint8_t>> programs;
+    for (int k = 0; k < count; ++k) programs.push_back(builtin_warrior(kinds[k % 3], sizeof(Word)));
+
+    const int rounds = 100000;
+    BasicArena<Word> arena(core);
+    arena.set_cycle_budget(rounds);
+    measure("arena." + std::to_string(8 * sizeof(Word)) + "bit", variant, "Mcycles/s", 1e6, [&]() {
+        arena.load_warriors(programs);
+        arena.simulate(rounds);
+        long long executed = 0;
+        for (auto& w : arena.warriors) executed += w->instructions_executed;
+        return executed;
+    });
+}
+
+void bench_arenas() {
+    bench_arena<uint8_t>("core=256,warriors=2", 256, 2);
+    bench_arena<uint16_t>("core=1024,warriors=2", 1024, 2);
+    bench_arena<uint16_t>("core=65536,warriors=8", 65536, 8);
+    bench_arena<uint32_t>("core=16777216,warriors=8", 1 << 24, 8);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) min_seconds = std::atof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) evolve_threads = (unsigned)std::atoi(argv[++i]);
+        else filters.push_back(arg);
+    }
+    if (evolve_threads == 0) evolve_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    printf("{\"bench\":\"meta\",\"jit\":%s,\"hardware_threads\":%u,\"min_seconds\":%g}\n",
+           JitProgram::supported() ? "true" : "false", std::thread::hardware_concurrency(), min_seconds);
+
+    bench_vm();
+    bench_fitness();
+    bench_evolve();
+    bench_bio();
+    bench_arenas();
+    return 0;
+}
@@ -1,63 +1,301 @@
 #include "bio.h"
 #include <stdexcept>
 #include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BIO_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BIO_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint8_t NOISE = 0xFF;
+const size_t CHUNK = 1 << 20; // Stream buffer size
+
+// Byte -> its four bases, and character -> 2-bit value (NOISE if not ACGT)
+struct Tables {
+    char bases[256][4];
+    uint8_t value[256];
+
+    Tables() {
+        static const char ACGT[] = "ACGT";
+        for (int b = 0; b < 256; ++b) {
+            // Process 4 pairs of bits: 76 54 32 10
+            for (int i = 3; i >= 0; --i) bases[b][3 - i] = ACGT[(b >> (i * 2)) & 0x03];
+        }
+        std::memset(value, NOISE, sizeof(value));
+        value['A'] = 0b00;
+        value['C'] = 0b01;
+        value['G'] = 0b10;
+        value['T'] = 0b11;
+    }
+};
+
+const Tables& tables() {
+    static const Tables t;
+    return t;
+}
+
+void encode_bytes(const uint8_t* data, size_t n, std::string& dna) {
+    const Tables& t = tables();
+    size_t at = dna.size();
+    dna.resize(at + n * 4);
+    char* p = &dna[at];
+    for (size_t i = 0; i < n; ++i, p += 4) std::memcpy(p, t.bases[data[i]], 4);
+}
+
+int lowest_bit(unsigned m) { int i = 0; while (!(m & 1)) { m >>= 1; ++i; } return i; }
+int highest_bit(unsigned m) { int i = -1; while (m) { m >>= 1; ++i; } return i; }
+
+} // namespace
 
 std::string BioCompiler::encode(const std::vector<uint8_t>& data) {
     std::string dna = "ATG"; // Start Codon (Methionine)
+    dna.reserve(data.size() * 4 + 6);
+    encode_bytes(data.data(), data.size(), dna);
+    dna += "TAA"; // Stop Codon (Ochre)
+    return dna;
+}
+
+std::string BioCompiler::tag_width(const std::string& dna, int word_bytes) {
+    return "w" + std::to_string(8 * word_bytes) + ":" + dna;
+}
+
+int BioCompiler::width_tag(const std::string& dna) {
+    if (dna.compare(0, 4, "w16:") == 0) return 2;
+    if (dna.compare(0, 4, "w32:") == 0) return 4;
+    if (dna.compare(0, 3, "w8:") == 0) return 1;
+    return 0;
+}
+
+std::vector<uint8_t> BioCompiler::decode(const std::string& dna) {
+    // Bases between the first ATG (else the start) and the last TAA (else
+    // the end); anything that is not A/C/G/T is noise and skipped
+    std::vector<uint8_t> data;
+    DnaDecoder decoder([&](const uint8_t* p, size_t n) { data.insert(data.end(), p, p + n); }, false);
+    decoder.feed(dna.data(), dna.size());
+    decoder.finish();
+    return data;
+}
+
+bool BioCompiler::encode_stream(std::istream& in, std::ostream& out) {
+    std::vector<char> chunk(CHUNK);
+    std::string dna = "ATG";
+    while (in) {
+        in.read(chunk.data(), chunk.size());
+        encode_bytes((const uint8_t*)chunk.data(), (size_t)in.gcount(), dna);
+        out.write(dna.data(), dna.size());
+        dna.clear();
+    }
+    out << "TAA" << '\n';
+    return !in.bad() && (bool)out;
+}
+
+bool BioCompiler::decode_stream(std::istream& in, std::ostream& out) {
+    DnaDecoder decoder([&](const uint8_t* p, size_t n) { out.write((const char*)p, n); });
+    std::vector<char> chunk(CHUNK);
+    while (in) {
+        in.read(chunk.data(), chunk.size());
+        decoder.feed(chunk.data(), (size_t)in.gcount());
+    }
+    decoder.finish();
+    return !in.bad() && (bool)out;
+}
+
+bool BioCompiler::decode_file(const std::string& path, std::ostream& out) {
+#if BIO_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        std::ifstream in(path, std::ios::binary);
+        return in && decode_stream(in, out);
+    }
     
-    for (uint8_t byte : data) {
-        // Process 4 pairs of bits: 76 54 32 10
-        for (int i = 3; i >= 0; --i) {
-            uint8_t pair = (byte >> (i * 2)) & 0x03;
-            switch (pair) {
-                case 0b00: dna += 'A'; break;
-                case 0b01: dna += 'C'; break;
-                case 0b10: dna += 'G'; break;
-                case 0b11: dna += 'T'; break;
+    DnaDecoder decoder([&](const uint8_t* p, size_t n) { out.write((const char*)p, n); });
+    if (st.st_size > 0) {
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        // Fed in chunks so pages already decoded can be dropped again
+        const char* text = (const char*)map;
+        for (size_t at = 0; at < (size_t)st.st_size; at += CHUNK) {
+            size_t n = std::min(CHUNK, (size_t)st.st_size - at);
+            decoder.feed(text + at, n);
+            madvise((void*)(text + (at & ~(size_t)4095)), n & ~(size_t)4095, MADV_DONTNEED);
+        }
+        munmap(map, st.st_size);
+    }
+    close(fd);
+    decoder.finish();
+    return (bool)out;
+#else
+    std::ifstream in(path, std::ios::binary);
+    return in && decode_stream(in, out);
+#endif
+}
+
+// --- DnaDecoder ---
+
+DnaDecoder::DnaDecoder(Sink s, bool f) : sink(s), fasta(f) {}
+
+void DnaDecoder::feed(const char* text, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+#if BIO_SSE2
+        // Blocks of 16 bases once the record has started on a byte boundary
+        if (!searching && bits == 0 && !in_header && n - i >= 16) {
+            size_t scalar_run = 0;
+            if (simd_block(text + i, scalar_run)) {
+                i += 16;
+                continue;
             }
+            // Step up to and including the first noise character
+            for (size_t k = 0; k < scalar_run; ++k) step(text[i++]);
+            continue;
         }
+#endif
+        step(text[i++]);
+    }
+}
+
+void DnaDecoder::step(char c) {
+    if (fasta) {
+        if (in_header) {
+            if (c == '\n') { in_header = false; line_start = true; }
+            return;
+        }
+        if (line_start && c == '>') {
+            finish();
+            in_header = true;
+            return;
+        }
+        line_start = (c == '\n');
     }
     
-    dna += "TAA"; // Stop Codon (Ochre)
-    return dna;
+    size_t len = out_base + out.size(); // Record length before c
+    uint8_t val = tables().value[(uint8_t)c];
+    if (val != NOISE) {
+        current = (current << 2) | val;
+        bits += 2;
+        if (bits == 8) {
+            out.push_back(current);
+            current = 0;
+            bits = 0;
+        }
+    }
+    
+    if (p2 == 'T' && p1 == 'A' && c == 'A') mark_taa(len2);
+    if (searching && p2 == 'A' && p1 == 'T' && c == 'G') {
+        start_body();
+        return;
+    }
+    p2 = p1; len2 = len1;
+    p1 = c;  len1 = len;
 }
 
-std::vector<uint8_t> BioCompiler::decode(const std::string& dna) {
-    std::vector<uint8_t> data;
+#if BIO_SSE2
+bool DnaDecoder::simd_block(const char* p, size_t& scalar_run) {
+    __m128i c = _mm_loadu_si128((const __m128i*)p);
+    __m128i is_a = _mm_cmpeq_epi8(c, _mm_set1_epi8('A'));
+    __m128i is_t = _mm_cmpeq_epi8(c, _mm_set1_epi8('T'));
+    __m128i is_cg = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('C')), _mm_cmpeq_epi8(c, _mm_set1_epi8('G')));
+    unsigned valid = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(is_a, is_t), is_cg));
+    if (valid != 0xFFFF) {
+        scalar_run = lowest_bit(~valid) + 1;
+        return false;
+    }
     
-    // Simple parser: skip invalid chars, look for pairs
-    // Real bio-compiler would look for ATG/TAA, but here we assume clean input or just parse body
+    // A=0x41 C=0x43 G=0x47 T=0x54: x = (c >> 1) & 3 gives 0,1,3,2 and
+    // x ^ (x >> 1) puts G and T in order
+    __m128i x = _mm_and_si128(_mm_srli_epi16(c, 1), _mm_set1_epi8(3));
+    __m128i v = _mm_xor_si128(x, _mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(1)));
+    // Pairs of bases -> nibbles -> bytes, first base in the high bits
+    __m128i w = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 2), _mm_set1_epi16(0x00FC)), _mm_srli_epi16(v, 8));
+    w = _mm_packus_epi16(w, _mm_setzero_si128());
+    __m128i b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(w, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(w, 8));
+    b = _mm_packus_epi16(b, _mm_setzero_si128());
+    uint32_t packed = (uint32_t)_mm_cvtsi128_si32(b);
     
-    size_t start = dna.find("ATG");
-    if (start == std::string::npos) start = 0; else start += 3;
+    size_t base = out_base + out.size();
+    out.resize(out.size() + 4);
+    std::memcpy(&out[out.size() - 4], &packed, 4);
     
-    size_t end = dna.rfind("TAA");
-    if (end == std::string::npos) end = dna.length();
+    // Last TAA that ends in this block; record length before base j is base + j/4
+    unsigned ma = (unsigned)_mm_movemask_epi8(is_a);
+    unsigned mt = (unsigned)_mm_movemask_epi8(is_t);
+    unsigned taa = mt & (ma >> 1) & (ma >> 2);
+    bool found = true;
+    size_t at = 0;
+    if (taa) at = base + highest_bit(taa) / 4;
+    else if (p1 == 'T' && (ma & 3) == 3) at = len1;
+    else if (p2 == 'T' && p1 == 'A' && (ma & 1)) at = len2;
+    else found = false;
     
-    uint8_t current_byte = 0;
-    int bits_filled = 0;
+    p2 = p[14]; len2 = base + 3;
+    p1 = p[15]; len1 = base + 3;
+    line_start = false;
+    if (found) mark_taa(at);
+    return true;
+}
+#else
+bool DnaDecoder::simd_block(const char*, size_t& scalar_run) {
+    scalar_run = 16;
+    return false;
+}
+#endif
+
+void DnaDecoder::mark_taa(size_t at) {
+    cut_seen = true;
+    cut = at;
+    if (searching) return; // May still be thrown away if an ATG turns up
     
-    for (size_t i = start; i < end; ++i) {
-        char base = dna[i];
-        uint8_t val = 0;
-        
-        switch (base) {
-            case 'A': val = 0b00; break;
-            case 'C': val = 0b01; break;
-            case 'G': val = 0b10; break;
-            case 'T': val = 0b11; break;
-            default: continue; // Noise
-        }
-        
-        current_byte = (current_byte << 2) | val;
-        bits_filled += 2;
-        
-        if (bits_filled == 8) {
-            data.push_back(current_byte);
-            current_byte = 0;
-            bits_filled = 0;
-        }
+    // A later TAA can only move the end further out, so this much is final
+    if (at > flushed) {
+        sink(out.data() + (flushed - out_base), at - flushed);
+        flushed = at;
     }
+    // Sent bytes are dropped in batches, not on every TAA
+    if (flushed - out_base >= 4096) {
+        out.erase(out.begin(), out.begin() + (flushed - out_base));
+        out_base = flushed;
+    }
+}
+
+void DnaDecoder::start_body() {
+    taa_before = cut_seen;
+    searching = false;
+    cut_seen = false;
+    out.clear();
+    out_base = flushed = cut = 0;
+    current = 0;
+    bits = 0;
+    p1 = p2 = 0;
+    len1 = len2 = 0;
+}
+
+void DnaDecoder::finish() {
+    size_t end = out_base + out.size();
+    if (cut_seen) end = cut;
+    else if (!searching && taa_before) end = flushed; // Last TAA came before the ATG
+    if (end > flushed) sink(out.data() + (flushed - out_base), end - flushed);
     
-    return data;
+    start_body();
+    searching = true;
+    taa_before = false;
 }
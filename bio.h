@@ -3,12 +3,63 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <iosfwd>
 #include <cstdint>
 
 class BioCompiler {
 public:
     static std::string encode(const std::vector<uint8_t>& data);
     static std::vector<uint8_t> decode(const std::string& dna);
+
+    // Warrior DNA can carry its address width as a "w16:" prefix in front
+    // of the start codon, which decode() skips like any other noise.
+    // width_tag() is in bytes per address, 0 if the DNA has no tag.
+    static std::string tag_width(const std::string& dna, int word_bytes);
+    static int width_tag(const std::string& dna);
+
+    // Chunked conversion with bounded memory, for archives too big to hold.
+    // decode_* read FASTA-style text: '>' header lines are skipped and
+    // split records, and each record decodes like decode() would. Decoded
+    // records are written back to back. Return false on an I/O error.
+    static bool encode_stream(std::istream& in, std::ostream& out);
+    static bool decode_stream(std::istream& in, std::ostream& out);
+    static bool decode_file(const std::string& path, std::ostream& out); // mmap where available
+};
+
+// Incremental DNA -> bytes, fed in chunks of any size. Keeps only the
+// bytes decoded since the last TAA, since a later TAA may still become
+// the end of the record; everything before it goes to the sink.
+class DnaDecoder {
+public:
+    typedef std::function<void(const uint8_t*, size_t)> Sink;
+
+    explicit DnaDecoder(Sink sink, bool fasta = true);
+    void feed(const char* text, size_t n);
+    void finish(); // Ends the current record
+
+private:
+    Sink sink;
+    bool fasta;         // '>' at line start opens a header
+    bool in_header = false;
+    bool line_start = true;
+    bool searching = true; // No ATG yet: decoding from the record start, in case none comes
+    bool taa_before = false; // A TAA before the ATG (decode() then yields nothing)
+    bool cut_seen = false;   // A TAA after the start
+
+    std::vector<uint8_t> out; // Decoded bytes from out_base on
+    size_t out_base = 0;      // Record offset of out[0]
+    size_t flushed = 0;       // Bytes of this record already sent
+    size_t cut = 0;           // Record length at the last TAA
+    uint8_t current = 0;
+    int bits = 0;
+    char p1 = 0, p2 = 0;      // Previous two characters of the record
+    size_t len1 = 0, len2 = 0; // Record length before p1 and p2
+
+    void step(char c);
+    bool simd_block(const char* p, size_t& scalar_run); // 16 bases at once, else how many to step()
+    void mark_taa(size_t at);
+    void start_body();
 };
 
 #endif
@@ -1,8 +1,18 @@
 @echo off
 if not exist bin mkdir bin
 
+set SOURCES=vm.cpp darwin.cpp bio.cpp arena.cpp pool.cpp batch_vm.cpp jit.cpp fitness_cache.cpp fitness.cpp islands.cpp tournament.cpp disasm.cpp checkpoint.cpp metrics.cpp replay.cpp server.cpp
+
 echo Compiling Genesis Engine (VM + Darwin + Bio + Arena)...
-g++ -std=c++17 -O2 src/main.cpp src/vm.cpp src/darwin.cpp src/bio.cpp src/arena.cpp -o bin/genesis.exe
+g++ -std=c++17 -O2 main.cpp %SOURCES% -pthread -o bin/genesis.exe
+
+if %errorlevel% neq 0 (
+    echo Build Failed!
+    exit /b %errorlevel%
+)
+
+echo Compiling benchmarks...
+g++ -std=c++17 -O2 bench.cpp %SOURCES% -pthread -o bin/genesis_bench.exe
 
 if %errorlevel% neq 0 (
     echo Build Failed!
@@ -0,0 +1,74 @@
+#include "checkpoint.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHECKPOINT_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+size_t checkpoint_payload_offset(const CheckpointHeader& h) {
+    uint64_t text = (uint64_t)h.mode_bytes + h.target_bytes;
+    uint64_t offset = (h.header_bytes + text + 7) & ~(uint64_t)7;
+    return offset > SIZE_MAX ? SIZE_MAX : (size_t)offset;
+}
+
+MappedFile::~MappedFile() {
+#if CHECKPOINT_MMAP
+    if (mapped) munmap((void*)base, length);
+#endif
+}
+
+bool MappedFile::open(const std::string& path) {
+#if CHECKPOINT_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            base = (const uint8_t*)map;
+            length = st.st_size;
+            mapped = true;
+            return true;
+        }
+    }
+    close(fd);
+#endif
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    base = fallback.data();
+    length = fallback.size();
+    return true;
+}
+
+bool write_file_atomic(const std::string& path, const std::function<bool(FILE*)>& write) {
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+
+    bool ok = write(f) && std::fflush(f) == 0;
+#if CHECKPOINT_MMAP
+    ok = ok && fsync(fileno(f)) == 0;
+#endif
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+#ifdef _WIN32
+        // rename() won't replace an existing file here
+        std::remove(path.c_str());
+        if (std::rename(tmp.c_str(), path.c_str()) == 0) return true;
+#endif
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+// On-disk layout of a DarwinEngine checkpoint (native endianness):
+//
+//   CheckpointHeader
+//   mode, target                   (text, lengths in the header)
+//   padding to 8 bytes
+//   double fitness[population]
+//   uint8_t dna[population][dna_length]
+//
+// Bump CHECKPOINT_VERSION whenever this changes; older files are refused.
+const char CHECKPOINT_MAGIC[8] = { 'G', 'E', 'N', 'E', 'S', 'I', 'S', 'C' };
+// 2: counter-based RNG, the seed replaces the mt19937 state
+// 3: prune_threshold
+const uint32_t CHECKPOINT_VERSION = 3;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;  // sizeof(CheckpointHeader) of the writer
+    uint64_t population;
+    uint64_t generation;    // Generations completed
+    uint64_t seed;          // Every random draw derives from (seed, generation, ...)
+    uint32_t dna_length;
+    uint32_t mode_bytes;
+    uint32_t target_bytes;
+    uint32_t reserved;
+    double prune_threshold; // Fitness of the last elite, the --prune cutoff for the next generation
+};
+
+// Offset of the fitness array (and start of the fixed-size part)
+size_t checkpoint_payload_offset(const CheckpointHeader& h);
+
+// Read-only view of a whole file, mapped where the OS allows it and read
+// into memory otherwise
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<uint8_t> fallback;
+};
+
+// Writes path.tmp through `write`, syncs it, then renames it over path, so
+// a crash leaves either the old file or the new one but never half of one
+bool write_file_atomic(const std::string& path, const std::function<bool(FILE*)>& write);
+
+#endif
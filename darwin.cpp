@@ -1,179 +1,496 @@
 #include "darwin.h"
+#include "checkpoint.h"
 #include <algorithm>
 #include <iostream>
+#include <cstring>
 #include <cmath>
+#include <mutex>
+#include <atomic>
 
-DarwinEngine::DarwinEngine(size_t pop_size, int dna_size) 
-    : population_size(pop_size), dna_length(dna_size) {
+DarwinEngine::DarwinEngine(size_t pop_size, int dna_size, uint64_t seed) 
+    : fitness(&fitness_mode("string")), seed(seed), population_size(pop_size), dna_length(dna_size) {
     
-    std::random_device rd;
-    rng.seed(rd());
-    
-    std::uniform_int_distribution<int> byte_dist(0, 255);
+    population.resize(pop_size, dna_size);
     for (size_t i = 0; i < pop_size; ++i) {
-        Organism org;
-        org.dna.resize(dna_size);
+        CounterRng rng(seed, 0, i, STREAM_INIT);
+        uint8_t* dna = population.genome(i);
         for (int j = 0; j < dna_size; ++j) {
-            org.dna[j] = byte_dist(rng);
+            dna[j] = (uint8_t)rng.next();
         }
-        org.fitness = 0.0;
-        population.push_back(org);
     }
+
+    set_threads(1);
+    set_cache_capacity(1 << 16);
 }
 
 void DarwinEngine::set_target(const std::string& t) {
     target = t;
+    if (cache) cache->clear();
+    prune_threshold = -std::numeric_limits<double>::infinity();
 }
 
 void DarwinEngine::set_mode(const std::string& m) {
     mode = m;
+    fitness = &fitness_mode(m);
+    if (cache) cache->clear();
+    prune_threshold = -std::numeric_limits<double>::infinity();
 }
 
-double DarwinEngine::score_dna(const std::vector<uint8_t>& dna) {
-    GenesisVM vm;
-    
-    if (mode == "string") {
-        vm.load_program(dna);
-        vm.run();
-        std::string output = vm.get_output_string();
-        
-        double score = 0.0;
-        size_t len = std::min(output.length(), target.length());
-        for (size_t i = 0; i < len; ++i) {
-            int diff = std::abs((int)output[i] - (int)target[i]);
-            if (diff == 0) score += 100.0;
-            else score -= diff;
-        }
-        score -= std::abs((int)output.length() - (int)target.length()) * 50.0;
-        return score;
-    
-    } else if (mode == "math") {
-        struct TestCase { uint8_t in; uint8_t out; };
-        std::vector<TestCase> tests = {{2, 4}, {5, 10}, {10, 20}};
-        double score = 0.0;
-        for (const auto& t : tests) {
-            vm.reset();
-            vm.load_program(dna);
-            vm.registers[0] = t.in;
-            vm.run();
-            int result = vm.registers[0];
-            int diff = std::abs(result - t.out);
-            if (diff == 0) score += 100.0;
-            else score -= diff * 2;
-        }
-        return score;
+void DarwinEngine::set_loop_detection(bool on) {
+    detect_loops = on;
+}
 
-    } else if (mode == "survival") {
-        vm.reset();
-        vm.load_program(dna);
-        for(int i=0; i<50; ++i) vm.step();
-        
-        if (dna.size() > 0) {
-            std::uniform_int_distribution<int> pos_dist(0, dna.size()-1);
-            std::uniform_int_distribution<int> val_dist(0, 255);
-            vm.memory[pos_dist(rng)] = val_dist(rng); 
-            vm.memory[pos_dist(rng)] = val_dist(rng); 
-        }
-        
-        vm.run(); 
-        std::string output = vm.get_output_string();
-        double score = 0.0;
-        if (output.find(target) != std::string::npos) {
-            score += 200.0; 
-            if (output.length() == target.length()) score += 50.0;
-        }
-        return score;
-
-    } else if (mode == "consciousness") {
-        // XOR Gate: Non-linear problem requiring JZ (Branching)
-        // 0,0 -> 0
-        // 0,1 -> 1
-        // 1,0 -> 1
-        // 1,1 -> 0
-        struct XORCase { uint8_t a; uint8_t b; uint8_t out; };
-        std::vector<XORCase> table = {{0,0,0}, {0,1,1}, {1,0,1}, {1,1,0}};
-        
-        double score = 0.0;
-        
-        for (const auto& t : table) {
-            vm.reset();
-            vm.load_program(dna);
-            vm.registers[0] = t.a;
-            vm.registers[1] = t.b;
-            vm.run();
-            
-            int result = vm.registers[0]; // Output strictly in R0
-            if (result == t.out) score += 100.0;
-            else score -= std::abs(result - t.out) * 10; // Punish deviation
-        }
-        return score;
+void DarwinEngine::set_pruning(bool on) {
+    pruning = on;
+}
+
+void DarwinEngine::set_cache_capacity(size_t n) {
+    if (n == 0) cache.reset();
+    else cache.reset(new FitnessCache(n));
+}
+
+void DarwinEngine::set_threads(unsigned n) {
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+    pool.reset(new WorkerPool(n));
+    workers.clear();
+    for (unsigned i = 0; i < n; ++i) {
+        workers.emplace_back(new WorkerState());
     }
-    
-    return 0.0;
+}
+
+void DarwinEngine::set_batch_eval(bool on) {
+    batch_eval = on;
+}
+
+void DarwinEngine::set_quiet(bool on) {
+    quiet = on;
+}
+
+void DarwinEngine::set_checkpoint(const std::string& path, int interval) {
+    checkpoint_path = path;
+    checkpoint_interval = path.empty() ? 0 : interval;
+}
+
+bool DarwinEngine::set_metrics(const std::string& path) {
+    metrics_log.reset(new metrics::GenerationLog());
+    if (!metrics_log->open(path)) {
+        metrics_log.reset();
+        return false;
+    }
+    metrics::collect(); // Start counting from here
+    return true;
+}
+
+void DarwinEngine::set_jit(bool on) {
+    use_jit = on && JitProgram::supported();
+}
+
+double DarwinEngine::score_dna(GenomeView dna, WorkerState& ws, uint32_t stream_seed, double threshold,
+                               bool& was_pruned) {
+    ScoreOptions options;
+    options.detect_loops = detect_loops;
+    options.jit = use_jit;
+    options.batch = batch_eval;
+    return score_genome(*fitness, options, dna, ws, target, stream_seed, threshold, &was_pruned);
 }
 
 void DarwinEngine::calculate_fitness() {
-    for (auto& org : population) {
-        org.fitness = score_dna(org.dna);
+    // Elites and tournament copies come back unchanged every generation;
+    // answer them from the cache and only score what is new.
+    bool cached = cache && fitness->deterministic;
+    pending.clear();
+    if (cached) {
+        genome_keys.resize(population.size());
+        for (size_t i = 0; i < population.size(); ++i) {
+            genome_keys[i] = FitnessCache::hash(population.genome(i), dna_length);
+            if (!cache->lookup(genome_keys[i], population.fitness[i])) pending.push_back(i);
+        }
+    } else {
+        for (size_t i = 0; i < population.size(); ++i) pending.push_back(i);
+    }
+    
+    // Pruned organisms only have an upper bound, see below
+    double threshold = -std::numeric_limits<double>::infinity();
+    if (pruning && fitness->deterministic) threshold = prune_threshold;
+    pruned.assign(pending.size(), 0);
+    if (batch_eval && fitness->score_batch) {
+        // Whole slices go to the BatchVM, so related organisms share its lanes
+        batch_views.resize(pending.size());
+        batch_scores.resize(pending.size());
+        for (size_t k = 0; k < pending.size(); ++k) batch_views[k] = population.view(pending[k]);
+        size_t slices = (pending.size() + BATCH_SLICE - 1) / BATCH_SLICE;
+        pool->parallel_for(slices, [&](size_t s, unsigned worker) {
+            size_t from = s * BATCH_SLICE;
+            size_t n = std::min(BATCH_SLICE, pending.size() - from);
+            fitness->score_batch(&batch_views[from], n, workers[worker]->batch, &batch_scores[from]);
+        });
+        for (size_t k = 0; k < pending.size(); ++k) population.fitness[pending[k]] = batch_scores[k];
+    } else {
+        pool->parallel_for(pending.size(), [&](size_t k, unsigned worker) {
+            size_t i = pending[k];
+            uint32_t stream_seed = CounterRng(seed, generation, i, STREAM_SCORE).next();
+            bool was_pruned;
+            population.fitness[i] = score_dna(population.view(i), *workers[worker], stream_seed, threshold, was_pruned);
+            pruned[k] = was_pruned;
+        });
+    }
+    
+    // Bounds are not cached: a cache hit is taken as an exact score
+    pruned_count = 0;
+    for (size_t k = 0; k < pending.size(); ++k) {
+        if (pruned[k]) pruned_count++;
+        else if (cached) cache->insert(genome_keys[pending[k]], population.fitness[pending[k]]);
+    }
+    if (pruned_count == 0) return;
+    
+    // A bound may be above the true score of an exactly scored loser, so
+    // pruned organisms drop below the lowest exact score and never win a
+    // tournament against one. Bounds below it keep their order.
+    double lowest = std::numeric_limits<double>::infinity();
+    for (size_t i = 0, k = 0; i < population.size(); ++i) {
+        bool bound = k < pending.size() && pending[k] == i && pruned[k++];
+        if (!bound) lowest = std::min(lowest, population.fitness[i]);
+    }
+    if (lowest == std::numeric_limits<double>::infinity()) return;
+    double ceiling = std::nextafter(lowest, -std::numeric_limits<double>::infinity());
+    for (size_t k = 0; k < pending.size(); ++k) {
+        if (pruned[k]) population.fitness[pending[k]] = std::min(population.fitness[pending[k]], ceiling);
     }
-    std::sort(population.begin(), population.end(), [](const Organism& a, const Organism& b) {
-        return a.fitness > b.fitness;
-    });
 }
 
-void DarwinEngine::selection() {
+// Only the elites need an order: nth_element splits them off and they alone
+// are sorted. Ties go to the higher index: the elites sit at the front, so
+// an equally fit newcomer replaces one and neutral drift keeps going.
+void DarwinEngine::sort_population() {
     size_t elite_count = population_size / 5;
-    std::vector<Organism> next_gen;
+    ranking.resize(population.size());
+    for (size_t i = 0; i < ranking.size(); ++i) ranking[i] = (uint32_t)i;
     
-    for (size_t i = 0; i < elite_count; ++i) {
-        next_gen.push_back(population[i]);
+    const double* score = population.fitness.data();
+    auto fitter = [score](uint32_t a, uint32_t b) {
+        if (score[a] != score[b]) return score[a] > score[b];
+        return a > b;
+    };
+    size_t ranked = std::max<size_t>(elite_count, 1);
+    std::nth_element(ranking.begin(), ranking.begin() + (ranked - 1), ranking.end(), fitter);
+    std::sort(ranking.begin(), ranking.begin() + ranked, fitter);
+    if (elite_count > 0) prune_threshold = score[ranking[elite_count - 1]];
+}
+
+// Builds the next generation in the spare slab and swaps it in; nothing is
+// allocated after the first generation. Each slot draws its own tournament
+// from CounterRng, so slots are filled in parallel blocks.
+void DarwinEngine::selection() {
+    size_t elite_count = population_size / 5;
+    if (next_population.size() != population.size() || next_population.dna_length() != population.dna_length()) {
+        next_population.resize(population.size(), population.dna_length());
     }
     
-    std::uniform_int_distribution<size_t> index_dist(0, population_size - 1);
-    while (next_gen.size() < population_size) {
-        size_t i1 = index_dist(rng);
-        size_t i2 = index_dist(rng);
-        size_t i3 = index_dist(rng);
+    for (size_t i = 0; i < elite_count; ++i) next_population.copy_row(i, population, ranking[i]);
+    
+    const double* score = population.fitness.data();
+    uint32_t n = (uint32_t)population_size;
+    for_each_block(elite_count, population_size, [&](size_t k) {
+        CounterRng rng(seed, generation, k, STREAM_SELECT);
+        uint32_t i1 = rng.below(n);
+        uint32_t i2 = rng.below(n);
+        uint32_t i3 = rng.below(n);
         
-        const Organism* winner = &population[i1];
-        if (population[i2].fitness > winner->fitness) winner = &population[i2];
-        if (population[i3].fitness > winner->fitness) winner = &population[i3];
+        uint32_t winner = i1;
+        if (score[i2] > score[winner]) winner = i2;
+        if (score[i3] > score[winner]) winner = i3;
         
-        next_gen.push_back(*winner); 
-    }
+        next_population.copy_row(k, population, winner);
+    });
     
-    population = next_gen;
+    population.swap(next_population);
 }
 
 void DarwinEngine::mutation() {
-    std::uniform_real_distribution<double> chance(0.0, 1.0);
-    std::uniform_int_distribution<int> byte_dist(0, 255);
-    std::uniform_int_distribution<int> pos_dist(0, dna_length - 1);
-    
     size_t elite_count = population_size / 5;
-    
-    for (size_t i = elite_count; i < population_size; ++i) {
-        if (chance(rng) < 0.1) { 
-             int pos = pos_dist(rng);
-             population[i].dna[pos] = byte_dist(rng); 
+    for_each_block(elite_count, population_size, [&](size_t i) {
+        CounterRng rng(seed, generation, i, STREAM_MUTATE);
+        if (rng.uniform() < 0.1) {
+            population.genome(i)[rng.below(dna_length)] = (uint8_t)rng.next();
         }
-    }
+    });
+}
+
+// Per-organism work is tiny, so the pool gets blocks of organisms
+template <typename F>
+void DarwinEngine::for_each_block(size_t begin, size_t end, F body) {
+    const size_t BLOCK = 1024;
+    if (end <= begin) return;
+    size_t blocks = (end - begin + BLOCK - 1) / BLOCK;
+    pool->parallel_for(blocks, [&](size_t b, unsigned) {
+        size_t from = begin + b * BLOCK;
+        size_t to = std::min(end, from + BLOCK);
+        for (size_t i = from; i < to; ++i) body(i);
+    });
 }
 
 void DarwinEngine::evolve(int generations) {
-    for (int g = 0; g < generations; ++g) {
+    for (int n = 0; n < generations; ++n) {
+        uint64_t g = generation;
+        metrics::Lap lap;
         calculate_fitness();
+        double fitness_s = lap();
+        sort_population();
+        double sort_s = lap();
+        double mean = 0;
+        if (metrics_log) {
+            for (double f : population.fitness) mean += f;
+            mean /= population.size();
+            lap();
+        }
         selection();
+        double selection_s = lap();
         mutation();
+        double mutation_s = lap();
+        ++generation;
+        
+        if (metrics_log) {
+            metrics::GenerationStats stats{ g, population.fitness[0], mean, pending.size(), pruned_count,
+                                            fitness_s, sort_s, selection_s, mutation_s, metrics::collect() };
+            metrics_log->write(stats);
+        }
+        
+        if (checkpoint_interval > 0 && generation % checkpoint_interval == 0) {
+            if (!save_checkpoint(checkpoint_path)) {
+                std::cerr << "Checkpoint: could not write " << checkpoint_path << std::endl;
+            }
+        }
         
         if (g % 100 == 0) {
-            std::cout << "Gen " << g << " | Best Fitness: " << population[0].fitness << std::endl;
-            if (population[0].fitness >= 400.0 && mode == "consciousness") return; // Perfect XOR (4*100)
-            if (population[0].fitness >= 300.0 && mode == "math") return; 
+            if (!quiet) std::cout << "Gen " << g << " | Best Fitness: " << population.fitness[0] << std::endl;
+            if (population.fitness[0] >= fitness->perfect) return;
         }
     }
 }
 
+// Steady-state evolution. Each worker loops on its own: pick a parent by
+// tournament, mutate a copy, score it without holding any lock, then let it
+// replace the loser of a second tournament if it is at least as fit. The
+// lock only covers row copies and bookkeeping, so a genome that runs to
+// MAX_CYCLES holds up its own worker and nobody else's.
+void DarwinEngine::evolve_steady(uint64_t evaluations, uint64_t report_every) {
+    calculate_fitness(); // Offspring of the last evolve() still carry their parents' scores
+    
+    const size_t n = population.size();
+    const double* score = population.fitness.data();
+    bool cached = cache && fitness->deterministic;
+    size_t best = std::max_element(population.fitness.begin(), population.fitness.end()) - population.fitness.begin();
+    
+    std::mutex lock;
+    std::atomic<uint64_t> issued{0};
+    std::atomic<bool> stop{population.fitness[best] >= fitness->perfect};
+    uint64_t done = 0;     // Offspring scored and placed
+    uint64_t reported = 0; // `done` at the last metrics line
+    uint64_t start = generation;
+    metrics::Lap lap;
+    
+    auto work = [&](unsigned worker) {
+        WorkerState& ws = *workers[worker];
+        std::vector<uint8_t> child(dna_length);
+        for (;;) {
+            uint64_t e = issued.fetch_add(1);
+            if (e >= evaluations || stop.load(std::memory_order_relaxed)) return;
+            CounterRng rng(seed, start + e / n, e % n, STREAM_STEADY);
+            uint32_t pick[6];
+            for (uint32_t& p : pick) p = rng.below((uint32_t)n);
+            
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                uint32_t parent = pick[0];
+                if (score[pick[1]] > score[parent]) parent = pick[1];
+                if (score[pick[2]] > score[parent]) parent = pick[2];
+                std::memcpy(child.data(), population.genome(parent), dna_length);
+            }
+            // A clone would only repeat its parent's evaluation, so every child mutates
+            child[rng.below(dna_length)] = (uint8_t)rng.next();
+            
+            double child_score = 0;
+            bool known = false;
+            uint64_t key = 0;
+            if (cached) {
+                key = FitnessCache::hash(child.data(), dna_length);
+                std::lock_guard<std::mutex> guard(lock);
+                known = cache->lookup(key, child_score);
+            }
+            if (!known) {
+                bool was_pruned;
+                child_score = score_dna(child, ws, rng.next(), -std::numeric_limits<double>::infinity(), was_pruned);
+            }
+            
+            std::lock_guard<std::mutex> guard(lock);
+            if (cached && !known) cache->insert(key, child_score);
+            uint32_t loser = pick[3];
+            if (score[pick[4]] < score[loser]) loser = pick[4];
+            if (score[pick[5]] < score[loser]) loser = pick[5];
+            if (child_score >= score[loser]) {
+                std::memcpy(population.genome(loser), child.data(), dna_length);
+                population.fitness[loser] = child_score;
+                if (child_score > score[best]) best = loser;
+            }
+            
+            ++done;
+            bool solved_now = !stop.load(std::memory_order_relaxed) && score[best] >= fitness->perfect;
+            if (solved_now) stop = true;
+            if (done % report_every == 0 || solved_now) {
+                if (!quiet) std::cout << "Evals " << done << " | Best Fitness: " << score[best] << std::endl;
+                if (metrics_log) {
+                    double mean = 0;
+                    for (double f : population.fitness) mean += f;
+                    // VM counters are per thread and still running, so they only reach the final summary
+                    metrics::VmCounters none;
+                    none.clear();
+                    metrics::GenerationStats stats{ start + done / n, score[best], mean / n, (size_t)(done - reported),
+                                                    0, lap(), 0, 0, 0, none };
+                    metrics_log->write(stats);
+                    reported = done;
+                }
+            }
+        }
+    };
+    
+    std::vector<WorkerPool::Task> tasks;
+    for (unsigned w = 0; w < pool->size(); ++w) tasks.push_back(work);
+    pool->run_tasks(std::move(tasks));
+    
+    generation = start + (done + n - 1) / n;
+    population.swap_rows(0, best); // get_best() reads row 0
+}
+
+Organism DarwinEngine::organism(size_t i) const {
+    return Organism{ population.view(i).to_vector(), population.fitness[i] };
+}
+
 Organism DarwinEngine::get_best() const {
-    return population[0];
+    return organism(0);
+}
+
+bool DarwinEngine::solved() const {
+    return population.fitness[0] >= fitness->perfect;
+}
+
+// Between generations the elites sit at the front in fitness order,
+// untouched by mutation
+std::vector<Organism> DarwinEngine::export_best(size_t n) const {
+    n = std::min(n, population.size());
+    std::vector<Organism> best;
+    for (size_t i = 0; i < n; ++i) best.push_back(organism(i));
+    return best;
+}
+
+void DarwinEngine::import_migrants(const std::vector<Organism>& migrants) {
+    size_t elite_count = population_size / 5;
+    size_t n = std::min(migrants.size(), population.size() - elite_count);
+    // Everything past the elites is a tournament copy; overwrite from the back
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = population.size() - 1 - k;
+        size_t len = std::min(migrants[k].dna.size(), (size_t)dna_length);
+        std::memcpy(population.genome(i), migrants[k].dna.data(), len);
+        population.fitness[i] = migrants[k].fitness;
+    }
+}
+
+// Saved between generations: the population is what the next generation
+// will score, and every later draw follows from seed and generation, so a
+// resumed run continues exactly where this one stops
+bool DarwinEngine::save_checkpoint(const std::string& path) const {
+    CheckpointHeader h;
+    std::memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.header_bytes = sizeof(CheckpointHeader);
+    h.population = population.size();
+    h.generation = generation;
+    h.seed = seed;
+    h.dna_length = dna_length;
+    h.mode_bytes = (uint32_t)mode.size();
+    h.target_bytes = (uint32_t)target.size();
+    h.reserved = 0;
+    h.prune_threshold = prune_threshold;
+    
+    return write_file_atomic(path, [&](FILE* f) {
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+        ok = ok && std::fwrite(mode.data(), 1, mode.size(), f) == mode.size();
+        ok = ok && std::fwrite(target.data(), 1, target.size(), f) == target.size();
+        
+        static const char zeros[8] = {};
+        size_t written = sizeof(h) + mode.size() + target.size();
+        size_t pad = checkpoint_payload_offset(h) - written;
+        ok = ok && std::fwrite(zeros, 1, pad, f) == pad;
+        
+        ok = ok && std::fwrite(population.fitness.data(), sizeof(double), population.size(), f) == population.size();
+        if (population.stride() == (size_t)dna_length) {
+            ok = ok && std::fwrite(population.genome(0), 1, population.slab_bytes(), f) == population.slab_bytes();
+        } else {
+            for (size_t i = 0; i < population.size(); ++i) {
+                ok = ok && std::fwrite(population.genome(i), 1, dna_length, f) == (size_t)dna_length;
+            }
+        }
+        return ok;
+    });
+}
+
+bool DarwinEngine::load_checkpoint(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Checkpoint: cannot open " << path << std::endl;
+        return false;
+    }
+    
+    CheckpointHeader h;
+    if (file.size() < sizeof(h)) {
+        std::cerr << "Checkpoint: " << path << " is truncated" << std::endl;
+        return false;
+    }
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0) {
+        std::cerr << "Checkpoint: " << path << " is not a Genesis checkpoint" << std::endl;
+        return false;
+    }
+    if (h.version != CHECKPOINT_VERSION || h.header_bytes != sizeof(h)) {
+        std::cerr << "Checkpoint: unsupported version " << h.version << std::endl;
+        return false;
+    }
+    
+    // Sizes come from the file, so check them by division before
+    // multiplying: a corrupt header must not wrap around to a small payload
+    size_t offset = checkpoint_payload_offset(h);
+    uint64_t row = sizeof(double) + (uint64_t)h.dna_length;
+    uint64_t payload = offset <= file.size() ? file.size() - offset : 0;
+    if (h.population == 0 || h.dna_length == 0 || offset > file.size() || h.population > payload / row ||
+        h.population * row != payload) {
+        std::cerr << "Checkpoint: " << path << " is truncated" << std::endl;
+        return false;
+    }
+    
+    const char* text = (const char*)file.data() + sizeof(h);
+    std::string saved_mode(text, h.mode_bytes);
+    std::string saved_target(text + h.mode_bytes, h.target_bytes);
+    if (saved_mode != mode || saved_target != target) {
+        std::cerr << "Checkpoint: " << path << " belongs to a " << saved_mode << " run" << std::endl;
+        return false;
+    }
+    
+    const uint8_t* fitness_values = file.data() + offset;
+    const uint8_t* slab = fitness_values + h.population * sizeof(double);
+    population.resize(h.population, h.dna_length);
+    std::memcpy(population.fitness.data(), fitness_values, h.population * sizeof(double));
+    if (population.stride() == h.dna_length) {
+        std::memcpy(population.genome(0), slab, population.slab_bytes());
+    } else {
+        for (size_t i = 0; i < h.population; ++i) {
+            std::memcpy(population.genome(i), slab + i * h.dna_length, h.dna_length);
+        }
+    }
+    
+    seed = h.seed;
+    population_size = h.population;
+    dna_length = h.dna_length;
+    generation = h.generation;
+    if (cache) cache->clear();
+    prune_threshold = h.prune_threshold;
+    return true;
 }
@@ -4,8 +4,16 @@
 #include <vector>
 #include <string>
 #include <random>
-#include "vm.h"
+#include <memory>
+#include <limits>
+#include "pool.h"
+#include "fitness.h"
+#include "fitness_cache.h"
+#include "metrics.h"
+#include "rng.h"
 
+// One organism on its own, for results and migration. Inside the engine
+// organisms are rows of a Population (genome.h).
 struct Organism {
     std::vector<uint8_t> dna;
     double fitness;
@@ -13,26 +21,95 @@ struct Organism {
 
 class DarwinEngine {
 public:
-    DarwinEngine(size_t pop_size, int dna_size);
+    DarwinEngine(size_t pop_size, int dna_size, uint64_t seed = std::random_device{}());
     void set_target(const std::string& target_str);
-    void set_mode(const std::string& m); // "string" or "math"
+    void set_mode(const std::string& m); // "string", "math", "survival" or "consciousness"
+    void set_threads(unsigned n);        // Fitness workers (0 = all cores)
+    void set_batch_eval(bool on);        // Run math/consciousness test cases on a BatchVM
+    void set_jit(bool on);               // Compile genomes to native code where supported
+    void set_cache_capacity(size_t n);   // Memoized genomes (0 = no cache)
+    void set_loop_detection(bool on);    // Stop evaluations early once the VM state repeats
+    void set_pruning(bool on);           // Stop scoring organisms that can no longer become elites
+    const FitnessCache* get_cache() const { return cache.get(); }
+    void set_quiet(bool on);             // No per-100-generation progress lines
+    void set_checkpoint(const std::string& path, int interval); // Save every `interval` generations (0 = never)
+    bool set_metrics(const std::string& path); // Per-generation stats (metrics.h), CSV if path ends in .csv
     void evolve(int generations);
+    // Steady-state alternative to evolve(): no generations and no barrier,
+    // see darwin.cpp. Runs up to `evaluations` offspring, printing progress
+    // every `report_every`, and counts each population-size worth of
+    // evaluations as one generation. Reproducible on one thread only.
+    void evolve_steady(uint64_t evaluations, uint64_t report_every);
     Organism get_best() const;
+    bool solved() const;                 // Best organism reached the mode's perfect score
+    uint64_t get_generation() const { return generation; } // Generations completed, including resumed ones
+    uint64_t get_seed() const { return seed; }
+    
+    // Whole-run snapshots (see checkpoint.h). Loading replaces the population,
+    // seed and generation count; mode and target must match the running engine.
+    bool save_checkpoint(const std::string& path) const;
+    bool load_checkpoint(const std::string& path);
+    
+    // Migration between islands: copies of the n fittest, and replacing the
+    // least fit with incoming organisms (scored again next generation)
+    std::vector<Organism> export_best(size_t n) const;
+    void import_migrants(const std::vector<Organism>& migrants);
 
 private:
-    std::vector<Organism> population;
+    Population population;
+    Population next_population; // selection() fills this, then swaps
+    std::vector<uint32_t> ranking;         // Organism indices, fittest first up to the elite cutoff
     std::string target;
     std::string mode = "string"; // Default
-    std::mt19937 rng;
+    const FitnessMode* fitness;  // Resolved from mode by set_mode
+    // All randomness is CounterRng(seed, generation, organism, stream), so
+    // results do not depend on the thread count or on the order of work
+    uint64_t seed;
+    enum Stream : uint32_t { STREAM_INIT, STREAM_SCORE, STREAM_SELECT, STREAM_MUTATE, STREAM_STEADY };
     size_t population_size;
     int dna_length;
+    uint64_t generation = 0;
+    
+    std::string checkpoint_path;
+    int checkpoint_interval = 0;
+    
+    std::unique_ptr<metrics::GenerationLog> metrics_log;
+
+    std::unique_ptr<WorkerPool> pool;
+    std::vector<std::unique_ptr<WorkerState>> workers; // One per pool thread
+    bool batch_eval = false;
+    bool use_jit = false;
+    bool detect_loops = false;
+    bool pruning = false;
+    // Fitness of the last elite of the previous ranking. The elites carry
+    // over unchanged, so nothing scoring below this can become one.
+    double prune_threshold = -std::numeric_limits<double>::infinity();
+    bool quiet = false;
+
+    // Deterministic modes only: survival scores depend on the radiation stream
+    std::unique_ptr<FitnessCache> cache;
+    std::vector<uint64_t> genome_keys;
+    std::vector<size_t> pending; // Organisms the cache could not answer
+    std::vector<uint8_t> pruned; // Per pending organism: scoring stopped early
+    size_t pruned_count = 0;
+    // --batch: pending organisms in slices of BATCH_SLICE per score_batch call
+    static constexpr size_t BATCH_SLICE = 64;
+    std::vector<GenomeView> batch_views;
+    std::vector<double> batch_scores;
 
     void calculate_fitness();
+    void sort_population(); // Ranks the elites only
     void selection();
     void mutation();
+    template <typename F> void for_each_block(size_t begin, size_t end, F body);
     void crossover();
     
-    double score_dna(const std::vector<uint8_t>& dna);
+    // stream_seed feeds the private RNG of "survival" mode, so a score only
+    // depends on (dna, seed) and not on which worker computed it.
+    // Scoring stops early (and sets `was_pruned`) once the result can't
+    // reach threshold.
+    double score_dna(GenomeView dna, WorkerState& ws, uint32_t stream_seed, double threshold, bool& was_pruned);
+    Organism organism(size_t i) const;
 };
 
 #endif
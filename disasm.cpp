@@ -0,0 +1,65 @@
+#include "disasm.h"
+#include "vm.h"
+#include <cstdio>
+
+size_t instruction_length(uint8_t op, int word_bytes) {
+    switch (op) {
+        case INC: case DEC: case IO: return 2;
+        case ADD: case SUB: case MOV: case LD: case ST: return 3;
+        case LDI: return 2 + word_bytes;
+        case JMP: case JZ: return 1 + word_bytes;
+        default: return 1; // NOP, HLT and unknown opcodes
+    }
+}
+
+std::vector<Instruction> disassemble(const std::vector<uint8_t>& code, int word_bytes) {
+    std::vector<Instruction> out;
+    auto at = [&](size_t i) -> uint8_t { return i < code.size() ? code[i] : 0; };
+    auto word = [&](size_t i) {
+        uint32_t v = 0;
+        for (int k = 0; k < word_bytes; ++k) v |= (uint32_t)at(i + k) << (8 * k);
+        return v;
+    };
+    
+    for (size_t pc = 0; pc < code.size(); ) {
+        Instruction insn;
+        insn.addr = pc;
+        insn.op = code[pc];
+        insn.length = instruction_length(insn.op, word_bytes);
+        insn.a = at(pc + 1);
+        insn.b = (insn.length >= 3) ? at(pc + 2) : 0;
+        insn.imm = 0;
+        if (insn.op == LDI) insn.imm = word(pc + 2);
+        if (insn.op == JMP || insn.op == JZ) { insn.imm = word(pc + 1); insn.a = 0; }
+        out.push_back(insn);
+        pc += insn.length;
+    }
+    return out;
+}
+
+std::string format_instruction(const Instruction& insn, int word_bytes) {
+    char buf[64];
+    int r1 = insn.a % 4, r2 = insn.b % 4;
+    int digits = word_bytes * 2;
+    switch (insn.op) {
+        case NOP: return "NOP";
+        case INC: std::snprintf(buf, sizeof(buf), "INC R%d", r1); break;
+        case DEC: std::snprintf(buf, sizeof(buf), "DEC R%d", r1); break;
+        case ADD: std::snprintf(buf, sizeof(buf), "ADD R%d, R%d", r1, r2); break;
+        case SUB: std::snprintf(buf, sizeof(buf), "SUB R%d, R%d", r1, r2); break;
+        case MOV: std::snprintf(buf, sizeof(buf), "MOV R%d, R%d", r1, r2); break;
+        case LDI: std::snprintf(buf, sizeof(buf), "LDI R%d, %u", r1, insn.imm); break;
+        case JMP: std::snprintf(buf, sizeof(buf), "JMP 0x%0*X", digits, insn.imm); break;
+        case JZ:  std::snprintf(buf, sizeof(buf), "JZ  0x%0*X", digits, insn.imm); break;
+        case IO:  std::snprintf(buf, sizeof(buf), "IO  %d", insn.a); break;
+        case LD:  std::snprintf(buf, sizeof(buf), "LD  R%d, [R%d]", r1, r2); break;
+        case ST:  std::snprintf(buf, sizeof(buf), "ST  [R%d], R%d", r1, r2); break;
+        case HLT: return "HLT";
+        default:  return "???";
+    }
+    return buf;
+}
+
+void emit_word(std::vector<uint8_t>& code, uint32_t v, int word_bytes) {
+    for (int k = 0; k < word_bytes; ++k) code.push_back((uint8_t)(v >> (8 * k)));
+}
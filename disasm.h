@@ -0,0 +1,32 @@
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// One decoded VIS instruction. word_bytes is the address width the code
+// was written for (1, 2 or 4): JMP/JZ targets and LDI immediates take that
+// many little-endian bytes.
+struct Instruction {
+    size_t addr;   // Offset of the opcode
+    size_t length; // Bytes including the opcode
+    uint8_t op;
+    uint8_t a, b;  // Register/port operands, raw
+    uint32_t imm;  // LDI value or JMP/JZ target
+};
+
+size_t instruction_length(uint8_t op, int word_bytes);
+
+// Linear sweep from offset 0. A trailing instruction cut short by the end
+// of the code reads its missing bytes as 0.
+std::vector<Instruction> disassemble(const std::vector<uint8_t>& code, int word_bytes);
+
+// "LDI R1, 20", "JMP 0x0006", ...
+std::string format_instruction(const Instruction& insn, int word_bytes);
+
+// Appends v as word_bytes little-endian bytes
+void emit_word(std::vector<uint8_t>& code, uint32_t v, int word_bytes);
+
+#endif
@@ -0,0 +1,221 @@
+#include "fitness.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "rng.h"
+#include "fitness_cache.h"
+
+double StringFitness::score(ScoreContext& ctx) {
+    CellVM& vm = ctx.ws.vm;
+    const std::string& target = ctx.target;
+    vm.reset();
+    vm.load_program(ctx.dna);
+    ctx.run();
+    const OutputBuffer& output = vm.output_buffer;
+    
+    // Compared in place; only stored bytes can match
+    double score = 0.0;
+    size_t len = std::min(output.stored(), target.length());
+    for (size_t i = 0; i < len; ++i) {
+        int diff = std::abs((int)(char)output[i] - (int)target[i]);
+        if (diff == 0) score += 100.0;
+        else score -= diff;
+    }
+    score -= std::abs((int)output.size() - (int)target.length()) * 50.0;
+    return score;
+}
+
+namespace {
+struct MathCase { uint8_t in; uint8_t out; };
+const MathCase math_tests[] = {{2, 4}, {5, 10}, {10, 20}};
+const int math_count = sizeof(math_tests) / sizeof(math_tests[0]);
+static_assert(math_count == MathFitness::cases, "one case per test");
+
+// XOR Gate: Non-linear problem requiring JZ (Branching)
+struct XORCase { uint8_t a; uint8_t b; uint8_t out; };
+const XORCase xor_table[] = {{0,0,0}, {0,1,1}, {1,0,1}, {1,1,0}};
+const int xor_count = sizeof(xor_table) / sizeof(xor_table[0]);
+static_assert(xor_count == ConsciousnessFitness::cases, "one case per row");
+
+double math_points(int result, int expected) {
+    int diff = std::abs(result - expected);
+    return diff == 0 ? 100.0 : -diff * 2;
+}
+
+double xor_points(int result, int expected) {
+    if (result == expected) return 100.0;
+    return -std::abs(result - expected) * 10; // Punish deviation
+}
+
+// Every case is worth at most 100 points, so after `done` of `count` cases
+// the final score can't exceed score + 100 per case left
+bool prune(ScoreContext& ctx, double& score, int done, int count) {
+    if (done == count) return false; // Exact anyway
+    double best = score + 100.0 * (count - done);
+    if (best >= ctx.threshold) return false;
+    score = best;
+    ctx.pruned = true;
+    return true;
+}
+
+// Fills the BatchVM with as many organisms as fit, every case of each in
+// its own lane, until the slice is done. Organisms related by descent share
+// most of their code and stay in lockstep much like the cases of one.
+// `setup` puts the inputs of a case in a lane, `points` scores it.
+template <typename Setup, typename Points>
+void score_slice(const GenomeView* dna, size_t count, BatchVM& batch, double* scores, int cases, Setup setup,
+                 Points points) {
+    const size_t per_run = BatchVM::LANES / cases;
+    for (size_t first = 0; first < count; first += per_run) {
+        size_t n = std::min(per_run, count - first);
+        batch.reset((int)n * cases);
+        for (size_t k = 0; k < n; ++k) {
+            for (int c = 0; c < cases; ++c) {
+                int lane = (int)k * cases + c;
+                batch.load_program(lane, dna[first + k]);
+                setup(lane, c);
+            }
+        }
+        batch.run();
+        for (size_t k = 0; k < n; ++k) {
+            double score = 0.0;
+            for (int c = 0; c < cases; ++c) score += points((int)k * cases + c, c);
+            scores[first + k] = score;
+        }
+    }
+}
+} // namespace
+
+double MathFitness::score(ScoreContext& ctx) {
+    CellVM& vm = ctx.ws.vm;
+    double score = 0.0;
+    for (int c = 0; c < math_count; ++c) {
+        vm.reset();
+        vm.load_program(ctx.dna);
+        vm.registers[0] = math_tests[c].in;
+        ctx.run();
+        score += math_points(vm.registers[0], math_tests[c].out);
+        if (prune(ctx, score, c + 1, math_count)) break;
+    }
+    return score;
+}
+
+void MathFitness::score_batch(const GenomeView* dna, size_t count, BatchVM& batch, double* scores) {
+    score_slice(dna, count, batch, scores, math_count,
+        [&](int lane, int c) { batch.registers[0][lane] = math_tests[c].in; },
+        [&](int lane, int c) { return math_points(batch.registers[0][lane], math_tests[c].out); });
+}
+
+// The first 50 steps never see radiation, so they run once; every trial
+// restores the VM to step 50 (only the pages the last trial dirtied) and
+// takes its own two hits. The score is the mean over all trials.
+double SurvivalFitness::score(ScoreContext& ctx) {
+    CellVM& vm = ctx.ws.vm;
+    GenomeView dna = ctx.dna;
+    vm.reset();
+    vm.load_program(dna);
+    for(int i=0; i<50; ++i) vm.step();
+    vm.take_snapshot(ctx.ws.snapshot);
+    
+    double score = 0.0;
+    for (int t = 0; t < SURVIVAL_TRIALS; ++t) {
+        if (t > 0) vm.restore(ctx.ws.snapshot);
+        if (dna.size() > 0) {
+            CounterRng radiation(ctx.stream_seed, 0, t, 0);
+            uint32_t n = (uint32_t)dna.size();
+            vm.poke(radiation.below(n), (uint8_t)radiation.next());
+            vm.poke(radiation.below(n), (uint8_t)radiation.next());
+        }
+        
+        vm.run();
+        const OutputBuffer& output = vm.output_buffer;
+        if (output.contains(ctx.target)) {
+            score += 200.0;
+            if (output.size() == ctx.target.length()) score += 50.0;
+        }
+    }
+    return score / SURVIVAL_TRIALS;
+}
+
+double ConsciousnessFitness::score(ScoreContext& ctx) {
+    CellVM& vm = ctx.ws.vm;
+    double score = 0.0;
+    for (int c = 0; c < xor_count; ++c) {
+        vm.reset();
+        vm.load_program(ctx.dna);
+        vm.registers[0] = xor_table[c].a;
+        vm.registers[1] = xor_table[c].b;
+        ctx.run();
+        score += xor_points(vm.registers[0], xor_table[c].out); // Output strictly in R0
+        if (prune(ctx, score, c + 1, xor_count)) break;
+    }
+    return score;
+}
+
+void ConsciousnessFitness::score_batch(const GenomeView* dna, size_t count, BatchVM& batch, double* scores) {
+    score_slice(dna, count, batch, scores, xor_count,
+        [&](int lane, int c) {
+            batch.registers[0][lane] = xor_table[c].a;
+            batch.registers[1][lane] = xor_table[c].b;
+        },
+        [&](int lane, int c) { return xor_points(batch.registers[0][lane], xor_table[c].out); });
+}
+
+namespace {
+template <typename Policy>
+FitnessMode make_mode(double perfect) {
+    FitnessMode m;
+    m.score = &Policy::score;
+    m.score_batch = nullptr;
+    if constexpr (Policy::batchable) m.score_batch = &Policy::score_batch;
+    m.deterministic = Policy::deterministic;
+    m.cases = Policy::cases;
+    m.perfect = perfect;
+    return m;
+}
+
+double zero_score(ScoreContext&) { return 0.0; }
+} // namespace
+
+const FitnessMode& fitness_mode(const std::string& name) {
+    const double never = std::numeric_limits<double>::infinity();
+    static const FitnessMode string_mode = make_mode<StringFitness>(never);
+    static const FitnessMode math_mode = make_mode<MathFitness>(300.0);
+    static const FitnessMode survival_mode = make_mode<SurvivalFitness>(never);
+    static const FitnessMode consciousness_mode = make_mode<ConsciousnessFitness>(400.0); // Perfect XOR (4*100)
+    static const FitnessMode unknown_mode = { &zero_score, nullptr, true, 1, never };
+    
+    if (name == "string") return string_mode;
+    if (name == "math") return math_mode;
+    if (name == "survival") return survival_mode;
+    if (name == "consciousness") return consciousness_mode;
+    return unknown_mode;
+}
+
+double score_genome(const FitnessMode& mode, const ScoreOptions& options, GenomeView dna, WorkerState& ws,
+                    const std::string& target, uint32_t stream_seed, double threshold, bool* pruned) {
+    if (pruned) *pruned = false;
+    if (options.batch && mode.score_batch) {
+        double score;
+        mode.score_batch(&dna, 1, ws.batch, &score);
+        return score;
+    }
+    
+    ws.vm.detect_cycles = options.detect_loops;
+    
+    // A compile costs about one interpreted run, so only genomes that run
+    // several times get one; it stays in the worker's JitCache for whenever
+    // the same genome is scored again
+    JitProgram* native = nullptr;
+    if (options.jit && mode.deterministic && mode.cases > 1) {
+        ws.vm.reset();
+        ws.vm.load_program(dna);
+        native = ws.jit.get(FitnessCache::hash(dna.data(), dna.size()), ws.vm);
+    }
+    
+    ScoreContext ctx{ dna, ws, target, stream_seed, native };
+    ctx.threshold = threshold;
+    double score = mode.score(ctx);
+    if (pruned) *pruned = ctx.pruned;
+    return score;
+}
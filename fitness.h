@@ -0,0 +1,105 @@
+#ifndef FITNESS_H
+#define FITNESS_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <limits>
+#include "vm.h"
+#include "batch_vm.h"
+#include "jit.h"
+
+// Per-thread scratch used while scoring; never shared between workers.
+struct WorkerState {
+    CellVM vm;
+    CellVM::Snapshot snapshot; // Survival: the VM after its radiation-free prefix
+    BatchVM batch;
+    JitCache jit;
+};
+
+// Everything a fitness policy may look at for one evaluation
+struct ScoreContext {
+    GenomeView dna;
+    WorkerState& ws;
+    const std::string& target;
+    uint32_t stream_seed; // Private RNG stream (survival radiation)
+    JitProgram* native;   // A translation of dna, or nullptr to interpret
+    // Branch and bound: a policy may stop as soon as the best score still
+    // reachable is below threshold, return that bound and set pruned. The
+    // caller then only knows the organism scores less than threshold.
+    double threshold = -std::numeric_limits<double>::infinity();
+    bool pruned = false;
+
+    void run() {
+        if (native) ws.jit.run(native, ws.vm);
+        else ws.vm.run();
+    }
+};
+
+// --- Fitness policies ---
+// Each mode is a type with a static score(). `deterministic` means the same
+// DNA always scores the same (so it may be cached or JIT-compiled), `cases`
+// is how many times score() runs a genome, and `batchable` means it also
+// provides score_batch(), which runs a slice of organisms on a BatchVM, all
+// their cases at once. Modes with several test cases honour
+// ScoreContext::threshold; score_batch never prunes.
+
+struct StringFitness {
+    static constexpr bool deterministic = true;
+    static constexpr int cases = 1;
+    static constexpr bool batchable = false;
+    static double score(ScoreContext& ctx);
+};
+
+struct MathFitness { // f(x) = 2x
+    static constexpr bool deterministic = true;
+    static constexpr int cases = 3;
+    static constexpr bool batchable = true;
+    static double score(ScoreContext& ctx);
+    static void score_batch(const GenomeView* dna, size_t count, BatchVM& batch, double* scores);
+};
+
+struct SurvivalFitness { // Print target despite radiation
+    static constexpr int SURVIVAL_TRIALS = 8; // Independent radiation hits per evaluation
+    static constexpr bool deterministic = false;
+    static constexpr int cases = SURVIVAL_TRIALS;
+    static constexpr bool batchable = false;
+    static double score(ScoreContext& ctx);
+};
+
+struct ConsciousnessFitness { // XOR gate
+    static constexpr bool deterministic = true;
+    static constexpr int cases = 4;
+    static constexpr bool batchable = true;
+    static double score(ScoreContext& ctx);
+    static void score_batch(const GenomeView* dna, size_t count, BatchVM& batch, double* scores);
+};
+
+// A policy resolved once by DarwinEngine::set_mode
+struct FitnessMode {
+    double (*score)(ScoreContext&);
+    // Scores dna[0, count) into scores[]; nullptr if not batchable
+    void (*score_batch)(const GenomeView* dna, size_t count, BatchVM& batch, double* scores);
+    bool deterministic;
+    int cases;
+    double perfect; // evolve() stops once the best organism reaches this
+};
+
+// Unknown names score every genome 0
+const FitnessMode& fitness_mode(const std::string& name);
+
+// How score_genome runs a genome
+struct ScoreOptions {
+    bool detect_loops = false; // CellVM::detect_cycles
+    bool jit = false;         // Run deterministic genomes with several cases as native code
+    bool batch = false;       // Use the mode's score_batch if it has one
+};
+
+// One evaluation, set up the same way for every caller (DarwinEngine,
+// JobServer). threshold and pruned work as in ScoreContext; batch scoring
+// never prunes.
+double score_genome(const FitnessMode& mode, const ScoreOptions& options, GenomeView dna, WorkerState& ws,
+                    const std::string& target, uint32_t stream_seed,
+                    double threshold = -std::numeric_limits<double>::infinity(), bool* pruned = nullptr);
+
+#endif
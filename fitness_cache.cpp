@@ -0,0 +1,106 @@
+#include "fitness_cache.h"
+#include <cstring>
+
+FitnessCache::FitnessCache(size_t capacity) : max_entries(capacity < 1 ? 1 : capacity) {
+    size_t slots = 2;
+    while (slots < max_entries * 2) slots <<= 1;
+    table.assign(slots, Slot{0, 0.0, false, false});
+    mask = slots - 1;
+}
+
+// 64-bit multiply/rotate hash over 8-byte words; the tail is zero-padded
+// and the length is mixed in so "AB" and "AB\0" differ.
+uint64_t FitnessCache::hash(const uint8_t* data, size_t len) {
+    const uint64_t K = 0x9E3779B97F4A7C15ull;
+    uint64_t h = 0xCBF29CE484222325ull ^ (len * K);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * K;
+        h ^= h >> 29;
+    }
+    if (i < len) {
+        uint64_t w = 0;
+        std::memcpy(&w, data + i, len - i);
+        h = (h ^ w) * K;
+        h ^= h >> 29;
+    }
+    h ^= h >> 32;
+    h *= 0xD6E8FEB86659FD93ull;
+    h ^= h >> 32;
+    return h;
+}
+
+size_t FitnessCache::find(uint64_t key) const {
+    size_t pos = key & mask;
+    while (table[pos].used && table[pos].key != key) pos = (pos + 1) & mask;
+    return pos;
+}
+
+bool FitnessCache::lookup(uint64_t key, double& fitness) {
+    size_t pos = find(key);
+    if (table[pos].used) {
+        table[pos].referenced = true;
+        fitness = table[pos].fitness;
+        hits++;
+        return true;
+    }
+    misses++;
+    return false;
+}
+
+void FitnessCache::insert(uint64_t key, double fitness) {
+    size_t pos = find(key);
+    if (table[pos].used) {
+        table[pos].fitness = fitness;
+        return;
+    }
+    if (count >= max_entries) {
+        evict_one();
+        pos = find(key); // Deletion may have shifted the probe chain
+    }
+    table[pos] = Slot{key, fitness, true, false};
+    count++;
+}
+
+void FitnessCache::clear() {
+    for (auto& s : table) s.used = false;
+    count = 0;
+    hand = 0;
+}
+
+// CLOCK: sweep the table, giving referenced entries a second chance
+void FitnessCache::evict_one() {
+    for (;;) {
+        Slot& s = table[hand];
+        if (s.used) {
+            if (!s.referenced) {
+                erase_at(hand);
+                evictions++;
+                return;
+            }
+            s.referenced = false;
+        }
+        hand = (hand + 1) & mask;
+    }
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+void FitnessCache::erase_at(size_t pos) {
+    size_t hole = pos;
+    size_t next = (pos + 1) & mask;
+    while (table[next].used) {
+        size_t home = table[next].key & mask;
+        // Move the entry into the hole if the hole lies on its probe path
+        bool movable = (hole <= next) ? (home <= hole || home > next)
+                                      : (home <= hole && home > next);
+        if (movable) {
+            table[hole] = table[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    table[hole].used = false;
+    count--;
+}
@@ -0,0 +1,48 @@
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Bounded genome-hash -> fitness map with CLOCK eviction.
+// Keys are 64-bit content hashes of the DNA; a collision would need ~2^32
+// distinct genomes in the table at once, far past any capacity we use.
+// Not thread-safe: the engine probes and fills it outside the worker pool.
+class FitnessCache {
+public:
+    explicit FitnessCache(size_t capacity); // Max entries kept
+    
+    static uint64_t hash(const uint8_t* data, size_t len);
+    
+    bool lookup(uint64_t key, double& fitness); // Counts a hit or a miss
+    void insert(uint64_t key, double fitness);
+    void clear();
+    
+    size_t size() const { return count; }
+    size_t capacity() const { return max_entries; }
+    
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+private:
+    // Open addressing with linear probing; table is kept at most half full
+    struct Slot {
+        uint64_t key;
+        double fitness;
+        bool used;
+        bool referenced; // CLOCK bit, set on every hit
+    };
+    std::vector<Slot> table;
+    size_t mask;
+    size_t max_entries;
+    size_t count = 0;
+    size_t hand = 0;
+
+    size_t find(uint64_t key) const; // Slot holding key, or the empty slot where it would go
+    void evict_one();
+    void erase_at(size_t pos);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef GENOME_H
+#define GENOME_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+// Read-only window onto one genome, wherever it is stored. Converts from a
+// std::vector, so callers holding whole programs can pass those directly.
+struct GenomeView {
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+    GenomeView() = default;
+    GenomeView(const uint8_t* b, size_t n) : bytes(b), length(n) {}
+    GenomeView(const std::vector<uint8_t>& v) : bytes(v.data()), length(v.size()) {}
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    uint8_t operator[](size_t i) const { return bytes[i]; }
+    const uint8_t* begin() const { return bytes; }
+    const uint8_t* end() const { return bytes + length; }
+    std::vector<uint8_t> to_vector() const { return std::vector<uint8_t>(bytes, bytes + length); }
+};
+
+// A whole population as structure-of-arrays: every genome is a row of one
+// 64-byte aligned slab, and fitness values sit in their own array. Rows
+// are padded to a multiple of 16 bytes (padding stays zero), so a row
+// copy is a few aligned vector moves and neighbours never share a row.
+class Population {
+public:
+    static constexpr size_t ALIGN = 64;
+    static constexpr size_t ROW_ALIGN = 16;
+
+    std::vector<double> fitness;
+
+    void resize(size_t count, size_t dna_length) {
+        size_t row = (dna_length + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN;
+        size_t bytes = (count * row + ALIGN - 1) / ALIGN * ALIGN;
+        uint8_t* p = bytes ? (uint8_t*)::operator new[](bytes, std::align_val_t(ALIGN)) : nullptr;
+        if (p) std::memset(p, 0, bytes);
+        slab.reset(p);
+        n = count;
+        length = dna_length;
+        stride_bytes = row;
+        fitness.assign(count, 0.0);
+    }
+
+    size_t size() const { return n; }
+    size_t dna_length() const { return length; }
+    size_t stride() const { return stride_bytes; }
+    size_t slab_bytes() const { return n * stride_bytes; }
+
+    uint8_t* genome(size_t i) { return slab.get() + i * stride_bytes; }
+    const uint8_t* genome(size_t i) const { return slab.get() + i * stride_bytes; }
+    GenomeView view(size_t i) const { return GenomeView(genome(i), length); }
+
+    // Row `to` becomes a copy of row `from` of `src` (same shape)
+    void copy_row(size_t to, const Population& src, size_t from) {
+        std::memcpy(genome(to), src.genome(from), stride_bytes);
+        fitness[to] = src.fitness[from];
+    }
+
+    void swap_rows(size_t a, size_t b) {
+        if (a == b) return;
+        uint8_t* x = genome(a);
+        uint8_t* y = genome(b);
+        for (size_t k = 0; k < stride_bytes; ++k) std::swap(x[k], y[k]);
+        std::swap(fitness[a], fitness[b]);
+    }
+
+    void swap(Population& other) {
+        std::swap(fitness, other.fitness);
+        std::swap(slab, other.slab);
+        std::swap(n, other.n);
+        std::swap(length, other.length);
+        std::swap(stride_bytes, other.stride_bytes);
+    }
+
+private:
+    struct AlignedFree {
+        void operator()(uint8_t* p) const { ::operator delete[](p, std::align_val_t(ALIGN)); }
+    };
+    std::unique_ptr<uint8_t[], AlignedFree> slab;
+    size_t n = 0;
+    size_t length = 0;
+    size_t stride_bytes = 0;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "islands.h"
+#include "rng.h"
+#include <algorithm>
+#include <iostream>
+
+IslandModel::IslandModel(size_t count, size_t pop_per_island, int dna_size, uint64_t seed) : seed(seed) {
+    for (size_t i = 0; i < count; ++i) {
+        CounterRng rng(seed, 0, i, STREAM_ISLAND);
+        uint64_t island_seed = rng.next();
+        island_seed |= (uint64_t)rng.next() << 32;
+        islands.emplace_back(new Island(pop_per_island, dna_size, island_seed));
+        islands.back()->engine.set_quiet(true);
+    }
+    best.fitness = -std::numeric_limits<double>::infinity();
+    set_threads(1);
+}
+
+void IslandModel::set_target(const std::string& t) {
+    for (auto& is : islands) is->engine.set_target(t);
+}
+
+void IslandModel::set_mode(const std::string& m) {
+    for (auto& is : islands) is->engine.set_mode(m);
+}
+
+void IslandModel::set_batch_eval(bool on) {
+    for (auto& is : islands) is->engine.set_batch_eval(on);
+}
+
+void IslandModel::set_jit(bool on) {
+    for (auto& is : islands) is->engine.set_jit(on);
+}
+
+void IslandModel::set_cache_capacity(size_t n) {
+    for (auto& is : islands) is->engine.set_cache_capacity(n);
+}
+
+void IslandModel::set_loop_detection(bool on) {
+    for (auto& is : islands) is->engine.set_loop_detection(on);
+}
+
+void IslandModel::set_pruning(bool on) {
+    for (auto& is : islands) is->engine.set_pruning(on);
+}
+
+void IslandModel::set_threads(unsigned n) {
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+    pool.reset(new WorkerPool(n));
+}
+
+void IslandModel::set_migration(int interval, size_t count, Topology t) {
+    migration_interval = std::max(1, interval);
+    migration_count = count;
+    topology = t;
+}
+
+void IslandModel::migrate(size_t from) {
+    Island& src = *islands[from];
+    size_t n = islands.size();
+    if (n > 1 && migration_count > 0) {
+        size_t to = (from + 1) % n;
+        if (topology == Topology::RANDOM) {
+            // One draw per island and migration, wherever the island is scheduled
+            CounterRng rng(seed, src.migrations++, from, STREAM_MIGRATE);
+            to = (from + 1 + rng.below((uint32_t)(n - 1))) % n;
+        }
+        std::vector<Organism> emigrants = src.engine.export_best(migration_count);
+        src.stats.migrants_out += emigrants.size();
+        
+        Island& dst = *islands[to];
+        std::lock_guard<std::mutex> lock(dst.inbox_lock);
+        dst.inbox.insert(dst.inbox.end(), emigrants.begin(), emigrants.end());
+    }
+    
+    std::vector<Organism> arrivals;
+    {
+        std::lock_guard<std::mutex> lock(src.inbox_lock);
+        arrivals.swap(src.inbox);
+    }
+    src.engine.import_migrants(arrivals);
+    src.stats.migrants_in += arrivals.size();
+}
+
+void IslandModel::run_epoch(size_t i, int generations, unsigned worker) {
+    Island& is = *islands[i];
+    int todo = std::min(migration_interval, generations - is.stats.generations);
+    is.engine.evolve(todo);
+    is.stats.generations += todo;
+    
+    Organism local = is.engine.get_best();
+    is.stats.best = std::max(is.stats.best, local.fitness);
+    {
+        std::lock_guard<std::mutex> lock(best_lock);
+        if (local.fitness > best.fitness) best = local;
+        // Island 0 reports for everyone, like the single-population progress line
+        if (i == 0 && is.stats.generations / 100 != (is.stats.generations - todo) / 100) {
+            std::cout << "Gen " << is.stats.generations << " | Best Fitness: " << best.fitness << std::endl;
+        }
+    }
+    
+    if (is.engine.solved()) finished = true;
+    if (finished || is.stats.generations >= generations) return;
+    
+    migrate(i);
+    pool->submit(worker, [this, i, generations](unsigned w) { run_epoch(i, generations, w); });
+}
+
+void IslandModel::evolve(int generations) {
+    finished = false;
+    for (auto& is : islands) is->stats.generations = 0;
+    
+    std::vector<WorkerPool::Task> tasks;
+    for (size_t i = 0; i < islands.size(); ++i) {
+        tasks.push_back([this, i, generations](unsigned w) { run_epoch(i, generations, w); });
+    }
+    pool->run_tasks(std::move(tasks));
+}
+
+Organism IslandModel::get_best() const {
+    std::lock_guard<std::mutex> lock(best_lock);
+    return best;
+}
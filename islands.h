@@ -0,0 +1,84 @@
+#ifndef ISLANDS_H
+#define ISLANDS_H
+
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include "darwin.h"
+#include "pool.h"
+
+enum class Topology {
+    RING,   // Island i sends to i+1
+    RANDOM  // Each migration picks a random other island
+};
+
+struct IslandStats {
+    int generations = 0; // Generations evolved so far
+    double best = -std::numeric_limits<double>::infinity(); // Best fitness seen on this island
+    size_t migrants_in = 0;
+    size_t migrants_out = 0;
+};
+
+// K independent DarwinEngines. Every island is a task on a work-stealing
+// pool that evolves `interval` generations, sends its best organisms to a
+// neighbour's inbox, takes in whatever has arrived in its own, and queues
+// itself again. Islands never wait for each other, so there is no barrier
+// between generations. With more than one thread, migrants land whenever
+// their sender gets there, so runs are only reproducible on one thread.
+class IslandModel {
+public:
+    IslandModel(size_t islands, size_t pop_per_island, int dna_size, uint64_t seed = std::random_device{}());
+
+    // Applied to every island
+    void set_target(const std::string& target_str);
+    void set_mode(const std::string& m);
+    void set_batch_eval(bool on);
+    void set_jit(bool on);
+    void set_cache_capacity(size_t n);
+    void set_loop_detection(bool on);
+    void set_pruning(bool on);
+
+    void set_threads(unsigned n);  // Islands evolved at once (0 = all cores)
+    void set_migration(int interval, size_t count, Topology topology);
+    void evolve(int generations);  // Stops early once any island is solved
+
+    Organism get_best() const;     // Best organism over all islands
+    size_t island_count() const { return islands.size(); }
+    IslandStats get_stats(size_t island) const { return islands[island]->stats; }
+
+private:
+    struct Island {
+        Island(size_t pop, int dna_size, uint64_t seed) : engine(pop, dna_size, seed) {}
+        DarwinEngine engine;
+        IslandStats stats;
+        uint64_t migrations = 0; // Counter for RANDOM destination draws
+
+        std::mutex inbox_lock;
+        std::vector<Organism> inbox;
+    };
+
+    // Counter-based streams of the model's own seed (rng.h), apart from the
+    // islands' engines, which run on seeds drawn from STREAM_ISLAND
+    enum Stream : uint32_t { STREAM_ISLAND = 16, STREAM_MIGRATE };
+
+    uint64_t seed;
+    std::vector<std::unique_ptr<Island>> islands;
+    std::unique_ptr<WorkerPool> pool;
+    int migration_interval = 50;
+    size_t migration_count = 2;
+    Topology topology = Topology::RING;
+
+    mutable std::mutex best_lock;
+    Organism best;
+    std::atomic<bool> finished{false};
+
+    void run_epoch(size_t i, int generations, unsigned worker);
+    void migrate(size_t from);
+};
+
+#endif
@@ -0,0 +1,457 @@
+#include "jit.h"
+#include "metrics.h"
+#include "disasm.h"
+#include "fitness_cache.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define GENESIS_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// State shared with native code. rbx points here while a program runs.
+struct JitFrame {
+    uint8_t regs[4];    // +0  R0..R3
+    int32_t budget;     // +4  Cycles left (MAX_CYCLES - instructions_executed)
+    uint8_t* memory;    // +8  Cell memory (r13)
+    uint32_t exit_ip;   // +16 ip when native code returned
+    CellVM* vm;         // +24 For IO callbacks
+    const uint8_t* code_map; // +32 Nonzero for bytes that reachable code reads
+};
+
+// Why native code returned
+enum JitExit { EXIT_HALT = 0, EXIT_BUDGET = 1, EXIT_REWRITE = 2 };
+
+// Per program: 256 worst-case blocks and the exit, rounded up to pages
+static const size_t CODE_CAPACITY = 28 * 1024;
+
+// IO is rare and needs digit formatting, so native code calls back into C++
+extern "C" void genesis_jit_io(JitFrame* f, int port) noexcept {
+    if (port == 0) {
+        f->vm->output_buffer.push_back(f->regs[0]);
+    } else {
+        f->vm->output_buffer.append_number(f->regs[0]);
+    }
+}
+
+#if GENESIS_JIT
+// On Linux the pages are mapped twice from one memfd, writable and
+// executable, so a compile is a plain memory write. Elsewhere (or if that
+// is refused) writable is null and compile() flips the pages with mprotect,
+// two syscalls and TLB flushes that cost more than translating a genome.
+static bool map_pages(size_t bytes, uint8_t*& code, uint8_t*& writable) {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    int fd = memfd_create("genesis-jit", MFD_CLOEXEC);
+    if (fd >= 0) {
+        void* w = MAP_FAILED;
+        void* x = MAP_FAILED;
+        if (ftruncate(fd, (off_t)bytes) == 0) {
+            w = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            x = mmap(nullptr, bytes, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (w != MAP_FAILED && x != MAP_FAILED) {
+            code = (uint8_t*)x;
+            writable = (uint8_t*)w;
+            return true;
+        }
+        if (w != MAP_FAILED) munmap(w, bytes);
+        if (x != MAP_FAILED) munmap(x, bytes);
+    }
+#endif
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+    code = (uint8_t*)p;
+    writable = nullptr;
+    return true;
+}
+
+static void unmap_pages(size_t bytes, uint8_t* code, uint8_t* writable) {
+    if (code) munmap(code, bytes);
+    if (writable) munmap(writable, bytes);
+}
+#endif
+
+JitProgram::JitProgram()
+    : code(nullptr), writable(nullptr), capacity(0), owns_code(true), ready(false), rewrites_itself(false) {
+#if GENESIS_JIT
+    if (map_pages(CODE_CAPACITY, code, writable)) capacity = CODE_CAPACITY;
+#endif
+}
+
+JitProgram::JitProgram(uint8_t* code, uint8_t* writable, size_t capacity)
+    : code(code), writable(writable), capacity(capacity), owns_code(false), ready(false), rewrites_itself(false) {}
+
+JitProgram::~JitProgram() {
+#if GENESIS_JIT
+    if (owns_code) unmap_pages(capacity, code, writable);
+#endif
+}
+
+bool JitProgram::matches(const CellVM& vm) const {
+    return ready && vm.owns_memory && vm.mem_size == 256 && std::memcmp(vm.memory, image, 256) == 0;
+}
+
+bool JitProgram::supported() {
+#if GENESIS_JIT
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if GENESIS_JIT
+
+namespace {
+
+// Minimal x86-64 emitter for the handful of instructions we need.
+// Writes through a raw cursor into a buffer sized for the worst case.
+struct Emitter {
+    uint8_t* base;
+    uint8_t* p;
+    struct Fixup { uint32_t at; uint32_t target; }; // rel32 at `at` -> label `target`
+    Fixup* fixups;
+    size_t fixup_count;
+
+    void b(std::initializer_list<uint8_t> bytes) { for (uint8_t x : bytes) *p++ = x; }
+    void imm32(uint32_t v) { std::memcpy(p, &v, 4); p += 4; }
+    void imm64(uint64_t v) { std::memcpy(p, &v, 8); p += 8; }
+    void rel32(int label) { fixups[fixup_count++] = { pos(), (uint32_t)label }; imm32(0); }
+    uint32_t pos() const { return (uint32_t)(p - base); }
+};
+
+// Labels 0..255 are blocks, 256..511 budget stubs, 512 the common exit
+const int LABEL_STUB = 256;
+const int LABEL_EXIT = 512;
+const uint32_t NO_BLOCK = ~0u; // Not reachable from where compile() started
+
+// Worst case per address: block (59 bytes for ST) plus its budget stub (24),
+// and up to three branches in a block plus one in its stub
+const size_t MAX_BLOCK_BYTES = 96;
+const size_t MAX_FIXUPS_PER_BLOCK = 4;
+static_assert(256 * MAX_BLOCK_BYTES + 64 <= CODE_CAPACITY, "a program must fit its code pages");
+
+// NOP and unknown opcodes only cost a cycle
+bool is_nop(uint8_t op) {
+    return op == NOP || (op > ST && op != HLT);
+}
+
+// Finds the blocks reachable from entry and marks every byte they read.
+// A block is one instruction, or a whole run of NOPs (like the zeros after
+// a short genome) that skips to its end; cost[a] is the cycles block a
+// charges, 0 if it's unreachable. Branch targets are immediates, so this is
+// exact: a store that leaves the marked bytes alone can't change which
+// instructions run or what they decode to, and control never leaves the
+// reachable blocks.
+void map_code(const uint8_t* image, uint8_t entry, int* cost, uint8_t* code_map) {
+    uint8_t todo[256];
+    int top = 0;
+    std::memset(cost, 0, 256 * sizeof(int));
+    std::memset(code_map, 0, 256);
+    todo[top++] = entry;
+    cost[entry] = -1; // Queued
+    auto visit = [&](uint8_t a) {
+        if (!cost[a]) { cost[a] = -1; todo[top++] = a; }
+    };
+    while (top > 0) {
+        uint8_t a = todo[--top];
+        uint8_t op = image[a];
+        int length = 1;
+        if (is_nop(op)) {
+            while (length < 256 && is_nop(image[(uint8_t)(a + length)])) ++length;
+            cost[a] = length;
+        } else {
+            length = (int)instruction_length(op, 1);
+            cost[a] = 1;
+        }
+        for (int k = 0; k < length; ++k) code_map[(uint8_t)(a + k)] = 1;
+        switch (op) {
+            case HLT: break;
+            case JMP: visit(image[(uint8_t)(a + 1)]); break;
+            case JZ: visit(image[(uint8_t)(a + 1)]); visit((uint8_t)(a + 2)); break;
+            default: visit((uint8_t)(a + length)); break;
+        }
+    }
+}
+
+} // namespace
+
+bool JitProgram::compile(const CellVM& vm) {
+    ready = false;
+    rewrites_itself = false;
+    if (!code || !vm.owns_memory || vm.mem_size != 256) return false;
+
+    std::memcpy(image, vm.memory, 256);
+    int cost[256];
+    map_code(image, (uint8_t)vm.ip, cost, code_map);
+    uint8_t buffer[256 * MAX_BLOCK_BYTES + 64];
+    Emitter::Fixup fixups[256 * MAX_FIXUPS_PER_BLOCK];
+    Emitter e{ buffer, buffer, fixups, 0 };
+    uint32_t label[LABEL_EXIT + 1];
+
+    // Prologue at offset 0: int entry(JitFrame* rdi, void* block rsi)
+    // Three pushes keep rsp 16-byte aligned for the IO call.
+    e.b({ 0x53 });                         // push rbx
+    e.b({ 0x41, 0x54 });                   // push r12
+    e.b({ 0x41, 0x55 });                   // push r13
+    e.b({ 0x48, 0x89, 0xFB });             // mov rbx, rdi
+    e.b({ 0x44, 0x8B, 0x63, 0x04 });       // mov r12d, [rbx+4]
+    e.b({ 0x4C, 0x8B, 0x6B, 0x08 });       // mov r13, [rbx+8]
+    e.b({ 0xFF, 0xE6 });                   // jmp rsi
+
+    // Only blocks reachable from vm.ip
+    for (int a = 0; a < 256; ++a) {
+        if (!cost[a]) {
+            label[a] = NO_BLOCK;
+            continue;
+        }
+        label[a] = (uint32_t)e.pos();
+        auto at = [&](int k) { return image[(uint8_t)(a + k)]; };
+        uint8_t op = at(0);
+        int next = (uint8_t)(a + 1);
+
+        // Charge the block; an exhausted budget exits before executing
+        if (cost[a] < 128) {
+            e.b({ 0x41, 0x83, 0xEC, (uint8_t)cost[a] });                  // sub r12d, cost
+        } else {
+            e.b({ 0x41, 0x81, 0xEC }); e.imm32(cost[a]);                  // sub r12d, cost
+        }
+        e.b({ 0x0F, 0x82 });               // jb stub[a]
+        e.rel32(LABEL_STUB + a);
+
+        switch (op) {
+            case INC:
+                e.b({ 0xFE, 0x43, (uint8_t)(at(1) % 4) });                 // inc byte [rbx+r]
+                next = (uint8_t)(a + 2);
+                break;
+            case DEC:
+                e.b({ 0xFE, 0x4B, (uint8_t)(at(1) % 4) });                 // dec byte [rbx+r]
+                next = (uint8_t)(a + 2);
+                break;
+            case ADD: case SUB: case MOV: {
+                uint8_t d = at(1) % 4, s = at(2) % 4;
+                uint8_t store = (op == ADD) ? 0x00 : (op == SUB) ? 0x28 : 0x88;
+                e.b({ 0x8A, 0x43, s });                                   // mov al, [rbx+s]
+                e.b({ store, 0x43, d });                                  // add/sub/mov [rbx+d], al
+                next = (uint8_t)(a + 3);
+                break;
+            }
+            case LDI:
+                e.b({ 0xC6, 0x43, (uint8_t)(at(1) % 4), at(2) });          // mov byte [rbx+d], imm8
+                next = (uint8_t)(a + 3);
+                break;
+            case JMP:
+                next = at(1);
+                break;
+            case JZ:
+                e.b({ 0x80, 0x3B, 0x00 });                                // cmp byte [rbx], 0
+                e.b({ 0x0F, 0x84 });                                      // je block[target]
+                e.rel32(at(1));
+                next = (uint8_t)(a + 2);
+                break;
+            case IO: {
+                uint8_t port = at(1);
+                if (port == 0 || port == 1) {
+                    e.b({ 0x48, 0x89, 0xDF });                            // mov rdi, rbx
+                    e.b({ 0xBE }); e.imm32(port);                         // mov esi, port
+                    e.b({ 0x48, 0xB8 }); e.imm64((uint64_t)(uintptr_t)&genesis_jit_io); // mov rax, fn
+                    e.b({ 0xFF, 0xD0 });                                  // call rax
+                }
+                next = (uint8_t)(a + 2);
+                break;
+            }
+            case LD: {
+                uint8_t d = at(1) % 4, r = at(2) % 4;
+                e.b({ 0x0F, 0xB6, 0x43, r });                             // movzx eax, byte [rbx+r]
+                e.b({ 0x41, 0x8A, 0x44, 0x05, 0x00 });                    // mov al, [r13+rax]
+                e.b({ 0x88, 0x43, d });                                   // mov [rbx+d], al
+                next = (uint8_t)(a + 3);
+                break;
+            }
+            case ST: {
+                uint8_t r = at(1) % 4, s = at(2) % 4;
+                next = (uint8_t)(a + 3);
+                e.b({ 0x0F, 0xB6, 0x43, r });                             // movzx eax, byte [rbx+r]
+                e.b({ 0x8A, 0x4B, s });                                   // mov cl, [rbx+s]
+                e.b({ 0x41, 0x38, 0x4C, 0x05, 0x00 });                    // cmp [r13+rax], cl
+                e.b({ 0x74, 30 });                                        // je (same byte: code unchanged)
+                e.b({ 0x41, 0x88, 0x4C, 0x05, 0x00 });                    // mov [r13+rax], cl
+                e.b({ 0x48, 0x8B, 0x53, 0x20 });                          // mov rdx, [rbx+32]
+                e.b({ 0x80, 0x3C, 0x02, 0x00 });                          // cmp byte [rdx+rax], 0
+                e.b({ 0x74, 15 });                                        // je (data byte: code unchanged)
+                e.b({ 0xB8 }); e.imm32(next);                             // mov eax, next
+                e.b({ 0xBA }); e.imm32(EXIT_REWRITE);                     // mov edx, EXIT_REWRITE
+                e.b({ 0xE9 }); e.rel32(LABEL_EXIT);                       // jmp exit
+                break;
+            }
+            case HLT:
+                e.b({ 0xB8 }); e.imm32((uint8_t)(a + 1));                 // mov eax, ip
+                e.b({ 0xBA }); e.imm32(EXIT_HALT);                        // mov edx, EXIT_HALT
+                e.b({ 0xE9 }); e.rel32(LABEL_EXIT);
+                continue;
+            default: // NOP and unknown opcodes, the whole run
+                next = (uint8_t)(a + cost[a]);
+                break;
+        }
+
+        if (next != a + 1) {
+            e.b({ 0xE9 }); e.rel32(next);                                 // jmp block[next]
+        }
+    }
+
+    // Budget stubs: the cost + r12d cycles that were left (r12d went
+    // negative) ran part of a NOP run, so stop at ip = a + those with
+    // nothing left
+    for (int a = 0; a < 256; ++a) {
+        if (!cost[a]) continue;
+        label[LABEL_STUB + a] = (uint32_t)e.pos();
+        e.b({ 0x41, 0x8D, 0x84, 0x24 }); e.imm32(a + cost[a]);            // lea eax, [r12 + a + cost]
+        e.b({ 0x0F, 0xB6, 0xC0 });                                        // movzx eax, al
+        e.b({ 0x45, 0x31, 0xE4 });                                        // xor r12d, r12d
+        e.b({ 0xBA }); e.imm32(EXIT_BUDGET);                              // mov edx, EXIT_BUDGET
+        e.b({ 0xE9 }); e.rel32(LABEL_EXIT);
+    }
+
+    // Common exit: eax = ip, edx = reason
+    label[LABEL_EXIT] = (uint32_t)e.pos();
+    e.b({ 0x89, 0x43, 0x10 });                                            // mov [rbx+16], eax
+    e.b({ 0x44, 0x89, 0x63, 0x04 });                                      // mov [rbx+4], r12d
+    e.b({ 0x89, 0xD0 });                                                  // mov eax, edx
+    e.b({ 0x41, 0x5D });                                                  // pop r13
+    e.b({ 0x41, 0x5C });                                                  // pop r12
+    e.b({ 0x5B });                                                        // pop rbx
+    e.b({ 0xC3 });                                                        // ret
+
+    size_t length = e.pos();
+
+    for (size_t i = 0; i < e.fixup_count; ++i) {
+        const auto& f = e.fixups[i];
+        int32_t rel = (int32_t)label[f.target] - (int32_t)(f.at + 4);
+        std::memcpy(buffer + f.at, &rel, 4);
+    }
+    std::memcpy(block_offset, label, sizeof(block_offset));
+
+    if (writable) {
+        // One bulk copy: the CPU sees a store to code it may have executed as
+        // self-modifying code and flushes its pipeline each time
+        std::memcpy(writable, buffer, length);
+    } else {
+        // W^X: only the pages we actually use are flipped writable and back
+        size_t span = (length + 4095) & ~(size_t)4095;
+        if (mprotect(code, span, PROT_READ | PROT_WRITE) != 0) return false;
+        std::memcpy(code, buffer, length);
+        if (mprotect(code, span, PROT_READ | PROT_EXEC) != 0) return false;
+    }
+
+    ready = true;
+    return true;
+}
+
+bool JitProgram::run_until_rewrite(CellVM& vm) {
+    if (vm.halted || vm.instructions_executed >= vm.MAX_CYCLES || !matches(vm) ||
+        block_offset[vm.ip] == NO_BLOCK) {
+        return false;
+    }
+
+    JitFrame f;
+    std::memcpy(f.regs, vm.registers, 4);
+    f.budget = vm.MAX_CYCLES - vm.instructions_executed;
+    f.memory = vm.memory;
+    f.exit_ip = vm.ip;
+    f.vm = &vm;
+    f.code_map = code_map; // From a later ip, a superset of the code that runs
+
+    typedef int (*Entry)(JitFrame*, const void*);
+    Entry enter = (Entry)(void*)code;
+    int reason = enter(&f, code + block_offset[vm.ip]);
+
+    std::memcpy(vm.registers, f.regs, 4);
+    vm.mark_all_dirty(); // Native stores don't track pages
+    vm.ip = (uint8_t)f.exit_ip;
+    vm.instructions_executed = vm.MAX_CYCLES - f.budget;
+
+    if (reason == EXIT_REWRITE) return true;
+    vm.halted = true;
+    if (reason == EXIT_HALT) metrics::count_halt(vm.instructions_executed);
+    else metrics::count_budget_hit();
+    return false;
+}
+
+JitCache::~JitCache() {
+    programs.clear(); // Before their pages go
+    unmap_pages(bytes, code, writable);
+}
+
+JitProgram* JitCache::get(uint64_t key, const CellVM& vm) {
+    if (programs.empty()) {
+        if (!map_pages((SLOTS + 1) * CODE_CAPACITY, code, writable)) return nullptr;
+        bytes = (SLOTS + 1) * CODE_CAPACITY;
+        keys.assign(SLOTS, 0);
+        programs.resize(SLOTS + 1);
+        for (size_t i = 0; i <= SLOTS; ++i) {
+            uint8_t* w = writable ? writable + i * CODE_CAPACITY : nullptr;
+            programs[i].reset(new JitProgram(code + i * CODE_CAPACITY, w, CODE_CAPACITY));
+        }
+    }
+    if (JitProgram* program = lookup(key, vm)) return program;
+    return translate(key, vm, nullptr);
+}
+
+#else
+
+bool JitProgram::compile(const CellVM&) {
+    return false;
+}
+
+bool JitProgram::run_until_rewrite(CellVM&) {
+    return false;
+}
+
+JitCache::~JitCache() {}
+
+JitProgram* JitCache::get(uint64_t, const CellVM&) {
+    return nullptr;
+}
+
+#endif
+
+void JitProgram::run(CellVM& vm) {
+    run_until_rewrite(vm);
+    if (!vm.halted) vm.run(); // Native code couldn't start, or a store rewrote it
+}
+
+JitProgram* JitCache::lookup(uint64_t key, const CellVM& vm) {
+    size_t slot = key & (SLOTS - 1);
+    if (keys[slot] != key || !programs[slot]->matches(vm)) return nullptr;
+    hits++;
+    return programs[slot].get();
+}
+
+JitProgram* JitCache::translate(uint64_t key, const CellVM& vm, const JitProgram* keep) {
+    size_t slot = key & (SLOTS - 1);
+    JitProgram* program = programs[slot].get();
+    if (program == keep) program = programs[SLOTS].get(); // Uncached, in the scratch slot
+    else keys[slot] = key;
+    compiles++;
+    return program->compile(vm) ? program : nullptr;
+}
+
+void JitCache::run(JitProgram* program, CellVM& vm) {
+    JitProgram* genome = program;
+    if (genome && genome->rewrites_itself) program = nullptr;
+    int compiled = 0;
+    while (program && program->run_until_rewrite(vm)) {
+        // Keyed by the whole cell: the same genome on the same case
+        // rewrites itself the same way every time
+        uint64_t key = FitnessCache::hash(vm.memory, 256) ^ vm.ip;
+        program = lookup(key, vm);
+        if (program) continue;
+        if (compiled++ == MAX_REWRITES) {
+            genome->rewrites_itself = true;
+            break;
+        }
+        program = translate(key, vm, genome); // Later cases still need the genome's own
+    }
+    if (!vm.halted) vm.run();
+}
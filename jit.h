@@ -0,0 +1,101 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "vm.h"
+
+// Native x86-64 translation of a 256-byte cell.
+// Every instruction reachable from the starting ip gets a block of machine
+// code (jumps may land anywhere, even mid-instruction), so JMP/JZ become
+// direct branches. Each block first charges the cycle budget, keeping
+// MAX_CYCLES semantics exact.
+// An ST that changes a byte of code reachable from the entry point leaves
+// native code and the run finishes in the interpreter (or, through a
+// JitCache, in a translation of the rewritten cell), so self-modifying
+// genomes behave as they do in the interpreter. Stores to data stay native.
+// On platforms without the JIT, run() is simply vm.run().
+class JitProgram {
+public:
+    JitProgram(); // Maps its own code pages
+    ~JitProgram();
+
+    JitProgram(const JitProgram&) = delete;
+    JitProgram& operator=(const JitProgram&) = delete;
+
+    static bool supported();
+
+    // Translates the code in vm.memory reachable from vm.ip. Needs a cell
+    // that owns exactly 256 bytes; returns false otherwise (run() then
+    // interprets).
+    bool compile(const CellVM& vm);
+
+    // Runs vm until halted. Uses native code only if vm.memory still matches
+    // the compiled image and vm.ip is one of the translated instructions.
+    void run(CellVM& vm);
+
+    // vm.memory is exactly what was compiled
+    bool matches(const CellVM& vm) const;
+
+private:
+    friend class JitCache;
+    JitProgram(uint8_t* code, uint8_t* writable, size_t capacity); // A slot of a JitCache
+
+    uint8_t* code;     // Executable view
+    uint8_t* writable; // Writable view of the same pages, or nullptr (flip with mprotect)
+    size_t capacity;
+    bool owns_code;
+    bool ready;
+    uint8_t image[256];
+    uint32_t block_offset[256];
+    uint8_t code_map[256]; // Bytes read by instructions reachable from the entry ip
+    bool rewrites_itself;  // JitCache::run gave up on it: interpret from now on
+
+    // Native code only: true if it stopped because a store rewrote
+    // reachable code. vm is left as it was if native code can't start.
+    bool run_until_rewrite(CellVM& vm);
+};
+
+// One worker's translations, keyed by FitnessCache::hash of the genome, so
+// a genome scored again (a tournament copy in the next generation, or any
+// repeat with the fitness cache off) runs without compiling. Direct-mapped:
+// a new genome takes over its slot. Code pages are mapped on first use.
+class JitCache {
+public:
+    static constexpr size_t SLOTS = 512;   // Power of two
+    static constexpr int MAX_REWRITES = 4; // Compiles per run before the interpreter takes over
+
+    JitCache() = default;
+    ~JitCache();
+
+    JitCache(const JitCache&) = delete;
+    JitCache& operator=(const JitCache&) = delete;
+
+    // A translation of vm.memory, compiled now unless key's slot already
+    // holds one. nullptr when the JIT can't run vm (run() it interpreted).
+    JitProgram* get(uint64_t key, const CellVM& vm);
+
+    // program->run(vm), except that a store to reachable code continues in
+    // a translation of the rewritten cell, cached like any other. A genome
+    // that keeps rewriting itself in new ways costs a compile per store, so
+    // once one run needs more than MAX_REWRITES its program only interprets.
+    void run(JitProgram* program, CellVM& vm);
+
+    uint64_t hits = 0;
+    uint64_t compiles = 0;
+
+private:
+    uint8_t* code = nullptr;
+    uint8_t* writable = nullptr;
+    size_t bytes = 0;
+    std::vector<std::unique_ptr<JitProgram>> programs; // SLOTS, then an uncached scratch
+    std::vector<uint64_t> keys;
+
+    JitProgram* lookup(uint64_t key, const CellVM& vm); // Counts a hit; nullptr on a miss
+    // Compiles into key's slot, or into the scratch if that slot holds keep
+    JitProgram* translate(uint64_t key, const CellVM& vm, const JitProgram* keep);
+};
+
+#endif
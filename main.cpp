@@ -1,35 +1,152 @@
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <thread>
 #include "darwin.h"
+#include "islands.h"
 #include "bio.h"
 #include "arena.h"
+#include "tournament.h"
+#include "replay.h"
+#include "server.h"
+#include "disasm.h"
 
-void print_asm_trace(const std::vector<uint8_t>& bytecode) {
+void print_asm_trace(const std::vector<uint8_t>& bytecode, int word_bytes) {
     std::cout << "Bytecode Size: " << bytecode.size() << " bytes" << std::endl;
-    std::cout << "Assembly Trace:" << std::endl;
-    
-    for (size_t i = 0; i < bytecode.size(); ++i) {
-        uint8_t op = bytecode[i];
-        printf("[%02X] ", op);
-        
-        switch(op) {
-            case NOP: std::cout << "NOP"; break;
-            case INC: std::cout << "INC"; break;
-            case DEC: std::cout << "DEC"; break;
-            case ADD: std::cout << "ADD"; break;
-            case SUB: std::cout << "SUB"; break;
-            case MOV: std::cout << "MOV"; break;
-            case LDI: std::cout << "LDI"; break;
-            case JMP: std::cout << "JMP"; break;
-            case JZ:  std::cout << "JZ "; break;
-            case IO:  std::cout << "IO "; break;
-            case LD:  std::cout << "LD "; break;
-            case ST:  std::cout << "ST "; break;
-            case HLT: std::cout << "HLT"; break;
-            default: std::cout << "???"; break;
-        }
-        std::cout << std::endl;
+    std::cout << "Assembly Trace (" << 8 * word_bytes << "-bit addresses):" << std::endl;
+    
+    for (const Instruction& insn : disassemble(bytecode, word_bytes)) {
+        printf("%04zX  ", insn.addr);
+        for (size_t i = 0; i < 6; ++i) {
+            if (i < insn.length && insn.addr + i < bytecode.size()) printf("%02X ", bytecode[insn.addr + i]);
+            else printf("   ");
+        }
+        std::cout << format_instruction(insn, word_bytes) << std::endl;
+    }
+}
+
+// Looks up "--name <value>" anywhere on the command line.
+const char* find_option(int argc, char* argv[], const std::string& name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (name == argv[i]) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// True if the bare switch `name` is on the command line
+bool has_flag(int argc, char* argv[], const std::string& name) {
+    for (int i = 1; i < argc; ++i) {
+        if (name == argv[i]) return true;
+    }
+    return false;
+}
+
+// "--width 8|16|32" as bytes per address
+int find_width(int argc, char* argv[], int fallback_bytes) {
+    const char* opt = find_option(argc, argv, "--width");
+    if (!opt) return fallback_bytes;
+    int bits = std::atoi(opt);
+    if (bits != 8 && bits != 16 && bits != 32) {
+        std::cerr << "Unsupported --width " << opt << ", using " << 8 * fallback_bytes << std::endl;
+        return fallback_bytes;
+    }
+    return bits / 8;
+}
+
+// Bytes per address for warrior DNA. Tagged DNA (as `export` writes it)
+// must match --width; untagged DNA is read at --width, by default 8 bits like
+// evolved genomes. 0 if the widths disagree.
+int dna_width(int argc, char* argv[], const std::vector<std::string>& dna) {
+    bool forced = find_option(argc, argv, "--width") != nullptr;
+    int width = forced ? find_width(argc, argv, 1) : 0;
+    for (size_t i = 0; i < dna.size(); ++i) {
+        int tag = BioCompiler::width_tag(dna[i]);
+        if (!tag && forced) continue;
+        if (!tag) tag = 1;
+        if (width && tag != width) {
+            std::cerr << "DNA " << i + 1 << " is " << 8 * tag << "-bit code, but "
+                      << (forced ? "--width is " : "other DNA is ") << 8 * width << "-bit" << std::endl;
+            return 0;
+        }
+        width = tag;
+    }
+    return width ? width : 1;
+}
+
+template <typename Word>
+void run_arena(const std::vector<std::vector<uint8_t>>& programs, size_t core, double fps, double speed,
+               double decisive, const char* record_path) {
+    BasicArena<Word> arena(core);
+    arena.set_decisive_share(decisive);
+    BattleRecorder recorder;
+    if (record_path) {
+        if (recorder.open(record_path)) arena.set_recorder(&recorder);
+        else std::cerr << "Replay: cannot write " << record_path << std::endl;
+    }
+    arena.load_warriors(programs);
+    arena.run_battle(5000, fps, speed);
+}
+
+// Plays a recorded battle from round `from` at `speed` rounds per second,
+// drawing `fps` frames per second; fps 0 jumps straight to the result
+int replay_battle(const std::string& path, int from, double fps, double speed) {
+    typedef std::chrono::steady_clock Clock;
+    BattlePlayer player;
+    if (!player.open(path) || !player.seek(from)) return 1;
+    if (fps <= 0 && !player.seek(player.rounds())) return 1;
+    
+    CoreRenderer view;
+    const auto frame_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0));
+    const auto start = Clock::now();
+    auto next_frame = start;
+    int first = player.round();
+    if (fps > 0) view.draw(player.memory(), player.ips(), player.round());
+    while (player.round() < player.rounds()) {
+        if (speed > 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>((player.round() - first) / speed)));
+        }
+        if (!player.next()) return 1;
+        if (fps > 0 && Clock::now() >= next_frame) {
+            view.draw(player.memory(), player.ips(), player.round());
+            next_frame = Clock::now() + frame_period;
+        }
+    }
+    if (fps > 0) view.draw(player.memory(), player.ips(), player.round());
+    
+    std::cout << "Rounds: " << player.rounds() << " | Winner: "
+              << (player.winner() ? "P" + std::to_string(player.winner()) : std::string("draw")) << std::endl;
+    size_t warriors = player.died().size();
+    for (size_t k = 0; k < warriors; ++k) {
+        int died = player.died()[k];
+        std::cout << "P" << k + 1 << " | Survived: " << (died < 0 ? player.rounds() : died)
+                  << " | Territory: " << player.territory(k) << std::endl;
     }
+    return 0;
+}
+
+// Instructions per second for `count` warriors sharing a core of `core` bytes.
+// Nothing in a round depends on the core size, so this should stay flat.
+template <typename Word>
+void bench_arena(size_t core, int count, int rounds) {
+    static const char* kinds[] = { "bomber", "replicator", "runner" };
+    if (count < 1 || core / count < 32) return; // No room for everyone
+    std::vector<std::vector<uint8_t>> programs;
+    for (int k = 0; k < count; ++k) programs.push_back(builtin_warrior(kinds[k % 3], sizeof(Word)));
+    
+    BasicArena<Word> arena(core);
+    arena.set_cycle_budget(rounds);
+    arena.load_warriors(programs);
+    auto start = std::chrono::steady_clock::now();
+    arena.simulate(rounds);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    long long executed = 0;
+    for (auto& w : arena.warriors) executed += w->instructions_executed;
+    printf("%2d-bit | core %9zu | warriors %3d | %8.1f M cycles/s\n",
+           (int)(8 * sizeof(Word)), core, count, seconds > 0 ? executed / seconds / 1e6 : 0.0);
 }
 
 int main(int argc, char* argv[]) {
@@ -41,64 +158,111 @@ int main(int argc, char* argv[]) {
         }
         std::string dna = argv[2];
         std::cout << "🧬 Bio-Decoder: Translating DNA..." << std::endl;
+        int width = dna_width(argc, argv, { dna });
+        if (!width) return 1;
         std::vector<uint8_t> bytecode = BioCompiler::decode(dna);
-        print_asm_trace(bytecode);
+        print_asm_trace(bytecode, width);
         return 0;
     }
     
+    // --- MODE 1.2: FILE ENCODE / DECODE (binary <-> DNA, "-" = stdin/stdout) ---
+    if (argc > 1 && (std::string(argv[1]) == "encode-file" || std::string(argv[1]) == "decode-file")) {
+        if (argc < 3) {
+            std::cout << "Usage: genesis.exe " << argv[1] << " <input|-> [output|-]" << std::endl;
+            return 1;
+        }
+        bool encoding = std::string(argv[1]) == "encode-file";
+        std::string in_path = argv[2];
+        std::string out_path = argc > 3 ? argv[3] : "-";
+
+        std::ofstream out_file;
+        if (out_path != "-") {
+            out_file.open(out_path, std::ios::binary);
+            if (!out_file) {
+                std::cerr << "Cannot write " << out_path << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out = out_path == "-" ? std::cout : out_file;
+
+        bool ok;
+        if (in_path == "-") {
+            std::ios::sync_with_stdio(false);
+            ok = encoding ? BioCompiler::encode_stream(std::cin, out) : BioCompiler::decode_stream(std::cin, out);
+        } else if (encoding) {
+            std::ifstream in(in_path, std::ios::binary);
+            ok = in && BioCompiler::encode_stream(in, out);
+        } else {
+            ok = BioCompiler::decode_file(in_path, out);
+        }
+        out.flush();
+        if (!ok) {
+            std::cerr << "Failed to " << (encoding ? "encode " : "decode ") << in_path << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     // --- MODE 1.5: EXPORT ---
     if (argc > 1 && std::string(argv[1]) == "export") {
         if (argc < 3) return 1;
         std::string type = argv[2];
-        std::vector<uint8_t> bytecode;
-        
-        if (type == "bomber") {
-            bytecode = { LDI, 0, 0, LDI, 1, 20, ST, 1, 0, INC, 1, JMP, 6 };
-        } else if (type == "runner") {
-            bytecode = { JMP, 0 }; 
-        } else if (type == "replicator") {
-            bytecode = { LDI, 0, 0, LDI, 1, 64, LD, 3, 0, ST, 1, 3, INC, 0, INC, 1, JMP, 6 };
-        } else {
-            return 1;
-        }
-        std::cout << BioCompiler::encode(bytecode) << std::endl;
+        int width = find_width(argc, argv, 2);
+        std::vector<uint8_t> bytecode = builtin_warrior(type, width);
+        if (bytecode.empty()) return 1;
+        std::cout << BioCompiler::tag_width(BioCompiler::encode(bytecode), width) << std::endl;
         return 0;
     }
 
     // --- MODE 1.8: TRANSPILE (Bio-Universal Translator) ---
     if (argc > 1 && std::string(argv[1]) == "transpile") {
         if (argc < 3) return 1;
+        int width = dna_width(argc, argv, { argv[2] });
+        if (!width) return 1;
         std::vector<uint8_t> bytecode = BioCompiler::decode(argv[2]);
+        // Memory wraps like the Arena's at this width: 256 bytes for 8-bit code
+        const char* core_opt = find_option(argc, argv, "--core");
+        size_t max_core = width == 1 ? Arena8::MAX_CORE : width == 2 ? Arena::MAX_CORE : Arena32::MAX_CORE;
+        size_t core = width == 1 ? Arena8::DEFAULT_CORE : width == 2 ? Arena::DEFAULT_CORE : Arena32::DEFAULT_CORE;
+        if (core_opt) core = std::max<size_t>(1, std::min<size_t>((size_t)std::atoll(core_opt), max_core));
+        std::string word = "uint" + std::to_string(8 * width) + "_t";
+        std::vector<Instruction> code = disassemble(bytecode, width);
+        auto is_label = [&](uint32_t t) {
+            for (const Instruction& insn : code) if (insn.addr == t) return true;
+            return false;
+        };
         
         std::cout << "// Bio-Transpiled C++ Source" << std::endl;
         std::cout << "#include <iostream>" << std::endl;
-        std::cout << "#include <vector>" << std::endl;
+        std::cout << "#include <cstdint>" << std::endl;
         std::cout << "int main() {" << std::endl;
-        std::cout << "    uint8_t r[4] = {0,0,0,0};" << std::endl;
-        std::cout << "    uint8_t m[1024] = {0};" << std::endl;
-        std::cout << "    int ip = 0;" << std::endl;
+        std::cout << "    " << word << " r[4] = {0,0,0,0};" << std::endl;
+        std::cout << "    static uint8_t m[" << core << "] = {0};" << std::endl;
         
         // Naive linear transpilation (Labels for jumps)
-        for (size_t i = 0; i < bytecode.size(); ++i) {
-             std::cout << "L" << i << ": ";
-             uint8_t op = bytecode[i];
-             
-             // Helpers for args
-             auto Fetch = [&]() { return (i + 1 < bytecode.size()) ? bytecode[++i] : 0; };
+        for (const Instruction& insn : code) {
+             std::cout << "L" << insn.addr << ": ";
+             int d = insn.a % 4, s = insn.b % 4;
              
-             switch(op) {
+             switch(insn.op) {
                  case NOP: std::cout << ";" << std::endl; break;
-                 case INC: { int reg = Fetch() % 4; std::cout << "r[" << reg << "]++;" << std::endl; break; }
-                 case DEC: { int reg = Fetch() % 4; std::cout << "r[" << reg << "]--;" << std::endl; break; }
-                 case ADD: { int d = Fetch() % 4; int s = Fetch() % 4; std::cout << "r[" << d << "] += r[" << s << "];" << std::endl; break; }
-                 case SUB: { int d = Fetch() % 4; int s = Fetch() % 4; std::cout << "r[" << d << "] -= r[" << s << "];" << std::endl; break; }
-                 case MOV: { int d = Fetch() % 4; int s = Fetch() % 4; std::cout << "r[" << d << "] = r[" << s << "];" << std::endl; break; }
-                 case LDI: { int d = Fetch() % 4; int v = Fetch(); std::cout << "r[" << d << "] = " << (int)v << ";" << std::endl; break; }
-                 case JMP: { int t = Fetch(); std::cout << "goto L" << (int)t << ";" << std::endl; break; } // Note: Might jump to invalid label if not watchful
-                 case JZ:  { int t = Fetch(); std::cout << "if (r[0]==0) goto L" << (int)t << ";" << std::endl; break; }
-                 case IO:  { int p = Fetch(); if (p==0) std::cout << "std::cout << (char)r[0];" << std::endl; else std::cout << "std::cout << (int)r[0];" << std::endl; break; }
+                 case INC: std::cout << "r[" << d << "]++;" << std::endl; break;
+                 case DEC: std::cout << "r[" << d << "]--;" << std::endl; break;
+                 case ADD: std::cout << "r[" << d << "] += r[" << s << "];" << std::endl; break;
+                 case SUB: std::cout << "r[" << d << "] -= r[" << s << "];" << std::endl; break;
+                 case MOV: std::cout << "r[" << d << "] = r[" << s << "];" << std::endl; break;
+                 case LDI: std::cout << "r[" << d << "] = " << insn.imm << ";" << std::endl; break;
+                 case JMP: case JZ: {
+                     if (insn.op == JZ) std::cout << "if (r[0]==0) ";
+                     if (is_label(insn.imm)) std::cout << "goto L" << insn.imm << ";" << std::endl;
+                     else std::cout << "return 0; // Jumps outside the genome" << std::endl;
+                     break;
+                 }
+                 case IO:  if (insn.a == 0) std::cout << "std::cout << (char)r[0];" << std::endl; else std::cout << "std::cout << (unsigned long)r[0];" << std::endl; break;
+                 case LD:  std::cout << "r[" << d << "] = m[r[" << s << "] % " << core << "];" << std::endl; break;
+                 case ST:  std::cout << "m[r[" << d << "] % " << core << "] = (uint8_t)r[" << s << "];" << std::endl; break;
                  case HLT: std::cout << "return 0;" << std::endl; break;
-                 default: std::cout << "// ??? " << (int)op << std::endl; break;
+                 default: std::cout << "// ??? " << (int)insn.op << std::endl; break;
              }
         }
         
@@ -110,52 +274,270 @@ int main(int argc, char* argv[]) {
     // --- MODE 2: ARENA ---
     if (argc > 1 && std::string(argv[1]) == "arena") {
         std::cout << "⚔️  Preparing Arena..." << std::endl;
-        Arena arena;
-        std::vector<uint8_t> p1 = { LDI, 0, 0, LDI, 1, 20, ST, 1, 0, INC, 1, JMP, 6 };
-        std::vector<uint8_t> p2 = { JMP, 0 };
-        if (argc >= 4) {
-            p1 = BioCompiler::decode(argv[2]);
-            p2 = BioCompiler::decode(argv[3]);
-        }
-        arena.load_warriors(p1, p2);
-        arena.run_battle(5000);
+        std::vector<std::string> dna;
+        for (int i = 2; i < argc && argv[i][0] != '-'; ++i) dna.push_back(argv[i]);
+        std::vector<std::vector<uint8_t>> programs;
+        int width;
+        if (dna.size() < 2) {
+            width = find_width(argc, argv, 2);
+            programs = { builtin_warrior("bomber", width), builtin_warrior("runner", width) };
+        } else {
+            width = dna_width(argc, argv, dna);
+            if (!width) return 1;
+            for (const std::string& d : dna) programs.push_back(BioCompiler::decode(d));
+        }
+        
+        const char* core_opt = find_option(argc, argv, "--core");
+        size_t core = core_opt ? (size_t)std::atoll(core_opt) : 0;
+        const char* fps_opt = find_option(argc, argv, "--fps");
+        double fps = fps_opt ? std::atof(fps_opt) : 20;
+        const char* speed_opt = find_option(argc, argv, "--speed");
+        double speed = speed_opt ? std::atof(speed_opt) : 1000;
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--no-render") fps = 0;
+        }
+        
+        const char* decisive_opt = find_option(argc, argv, "--decisive");
+        double decisive = decisive_opt ? std::atof(decisive_opt) : 0;
+        const char* record_opt = find_option(argc, argv, "--record");
+        if (width == 1) run_arena<uint8_t>(programs, core ? core : Arena8::DEFAULT_CORE, fps, speed, decisive, record_opt);
+        else if (width == 2) run_arena<uint16_t>(programs, core ? core : Arena::DEFAULT_CORE, fps, speed, decisive, record_opt);
+        else run_arena<uint32_t>(programs, core ? core : Arena32::DEFAULT_CORE, fps, speed, decisive, record_opt);
         return 0;
     }
+    
+    // --- MODE 2.1: REPLAY A RECORDED BATTLE ---
+    if (argc > 2 && std::string(argv[1]) == "replay") {
+        const char* seek_opt = find_option(argc, argv, "--seek");
+        const char* fps_opt = find_option(argc, argv, "--fps");
+        double fps = fps_opt ? std::atof(fps_opt) : 20;
+        const char* speed_opt = find_option(argc, argv, "--speed");
+        double speed = speed_opt ? std::atof(speed_opt) : 1000;
+        if (has_flag(argc, argv, "--no-render")) fps = 0;
+        return replay_battle(argv[2], seek_opt ? std::atoi(seek_opt) : 0, fps, speed);
+    }
+    
+    // --- MODE 2.2: ARENA BENCHMARK ---
+    if (argc > 1 && std::string(argv[1]) == "arena-bench") {
+        const char* warriors_opt = find_option(argc, argv, "--warriors");
+        int count = warriors_opt ? std::atoi(warriors_opt) : 8;
+        const char* rounds_opt = find_option(argc, argv, "--rounds");
+        int rounds = rounds_opt ? std::atoi(rounds_opt) : 1000000;
+        
+        bench_arena<uint8_t>(256, count, rounds);
+        for (size_t core = 1024; core <= 65536; core *= 4) bench_arena<uint16_t>(core, count, rounds);
+        for (size_t core = 1 << 18; core <= (1 << 24); core *= 4) bench_arena<uint32_t>(core, count, rounds);
+        return 0;
+    }
+
+    // --- MODE 2.5: TOURNAMENT ---
+    if (argc > 1 && std::string(argv[1]) == "tournament") {
+        Tournament tournament;
+        const char* threads_opt = find_option(argc, argv, "--threads");
+        tournament.set_threads(threads_opt ? (unsigned)std::atoi(threads_opt) : 0);
+        const char* cycles_opt = find_option(argc, argv, "--cycles");
+        if (cycles_opt) tournament.set_cycles(std::atoi(cycles_opt));
+        const char* budget_opt = find_option(argc, argv, "--budget");
+        if (budget_opt) tournament.set_cycle_budget(std::atoi(budget_opt));
+        const char* core_opt = find_option(argc, argv, "--core");
+        if (core_opt) tournament.set_core_size((size_t)std::atoll(core_opt));
+        const char* decisive_opt = find_option(argc, argv, "--decisive");
+        if (decisive_opt) tournament.set_decisive_share(std::atof(decisive_opt));
+        const char* record_opt = find_option(argc, argv, "--record-dir");
+        if (record_opt) tournament.set_record_dir(record_opt);
+        
+        // Library: one warrior per line, "name DNA" or just "DNA"; # starts a comment
+        if (argc >= 3 && argv[2][0] != '-') {
+            std::ifstream in(argv[2]);
+            if (!in) {
+                std::cerr << "Cannot open library " << argv[2] << std::endl;
+                return 1;
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.empty() || line[0] == '#') continue;
+                size_t space = line.find(' ');
+                std::string name = "W" + std::to_string(tournament.warrior_count());
+                std::string dna = line;
+                if (space != std::string::npos) {
+                    name = line.substr(0, space);
+                    dna = line.substr(space + 1);
+                }
+                int tag = BioCompiler::width_tag(dna);
+                if (tag && tag != Arena::WORD_BYTES) {
+                    std::cerr << "Skipping " << name << ": " << 8 * tag << "-bit DNA, tournaments are 16-bit" << std::endl;
+                    continue;
+                }
+                tournament.add_warrior(name, BioCompiler::decode(dna));
+            }
+        } else {
+            for (const char* type : { "bomber", "runner", "replicator" }) {
+                tournament.add_warrior(type, builtin_warrior(type, Arena::WORD_BYTES));
+            }
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        const char* swiss_opt = find_option(argc, argv, "--swiss");
+        if (swiss_opt) tournament.run_swiss(std::atoi(swiss_opt));
+        else tournament.run_round_robin();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        std::cout << "🏆 Tournament: " << tournament.battles_played() << " battles in " << seconds << " s ("
+                  << (seconds > 0 ? tournament.battles_played() / seconds : 0) << " battles/s)" << std::endl;
+        int rank = 1;
+        for (const Warrior& w : tournament.standings()) {
+            printf("%3d. %-16s Elo %7.1f | W %d L %d D %d\n", rank++, w.name.c_str(), w.rating, w.wins, w.losses, w.draws);
+        }
+        return 0;
+    }
+
+    // --- MODE 2.6: SERVE (jobs on stdin or a Unix socket) ---
+    if (argc > 1 && std::string(argv[1]) == "serve") {
+        const char* threads_opt = find_option(argc, argv, "--threads");
+        JobServer server(threads_opt ? (unsigned)std::atoi(threads_opt) : 0);
+        const char* cycles_opt = find_option(argc, argv, "--cycles");
+        if (cycles_opt) server.set_cycles(std::atoi(cycles_opt));
+        const char* budget_opt = find_option(argc, argv, "--budget");
+        if (budget_opt) server.set_cycle_budget(std::atoi(budget_opt));
+        const char* core_opt = find_option(argc, argv, "--core");
+        if (core_opt) server.set_core_size((size_t)std::atoll(core_opt));
+        const char* decisive_opt = find_option(argc, argv, "--decisive");
+        if (decisive_opt) server.set_decisive_share(std::atof(decisive_opt));
+        const char* seed_opt = find_option(argc, argv, "--seed");
+        if (seed_opt) server.set_seed(std::strtoull(seed_opt, nullptr, 10));
+        server.set_jit(has_flag(argc, argv, "--jit"));
+        
+        const char* socket_opt = find_option(argc, argv, "--socket");
+        if (socket_opt) return server.serve_socket(socket_opt) ? 0 : 1;
+        bool ok = server.serve(stdin, stdout);
+        std::cerr << "Serve: " << server.jobs_done() << " jobs" << std::endl;
+        return ok ? 0 : 1;
+    }
 
     // --- MODE 3: EVOLVE (Default) ---
     std::cout << "🧬 Project Genesis: Starting Evolution..." << std::endl;
     
     bool math_mode = (argc > 1 && std::string(argv[1]) == "math");
-    
-    DarwinEngine engine(1000, 32); 
+    std::string mode = "string";
+    std::string target;
+    int dna_size = 32;
     
     if (math_mode) {
          std::cout << "Target: Logic f(x) = x + x (Doubling)" << std::endl;
-         engine.set_mode("math"); 
+         mode = "math";
     } else if (argc > 1 && std::string(argv[1]) == "survival") {
          std::cout << "Target: Immortal Kernel (Survive Memory Corruption)" << std::endl;
-         engine.set_mode("survival");
-         engine.set_target("Hi"); 
-         // Re-initialize population with LARGER DNA (128 bytes) for redundancy
-         engine = DarwinEngine(1000, 128); 
-         engine.set_mode("survival");
-         engine.set_target("Hi");
+         mode = "survival";
+         target = "Hi";
+         dna_size = 128; // LARGER DNA for redundancy
     } else if (argc > 1 && std::string(argv[1]) == "consciousness") {
          std::cout << "Target: Vant-Genesis Merger (XOR Logic Gate)" << std::endl;
          std::cout << "Goal: Evolve Non-Linear Decision Making." << std::endl;
-         engine.set_mode("consciousness");
+         mode = "consciousness";
     } else {
-         std::string target = "Hi"; 
-         engine.set_target(target);
+         target = "Hi";
          std::cout << "Target: String [" << target << "]" << std::endl;
     }
     
-    std::cout << "Population: 1000 | DNA Size: 32 bytes" << std::endl;
-    engine.evolve(5000); 
+    const char* population_opt = find_option(argc, argv, "--population");
+    size_t population = population_opt ? (size_t)std::atoll(population_opt) : 1000;
+    const char* islands_opt = find_option(argc, argv, "--islands");
+    size_t island_count = islands_opt ? (size_t)std::atoll(islands_opt) : 1;
+    const char* threads_opt = find_option(argc, argv, "--threads");
+    unsigned threads = threads_opt ? (unsigned)std::atoi(threads_opt) : 1;
+    // Printed so any run can be repeated; results don't depend on --threads
+    const char* seed_opt = find_option(argc, argv, "--seed");
+    uint64_t seed = seed_opt ? std::strtoull(seed_opt, nullptr, 10) : std::random_device{}();
     
-    Organism best = engine.get_best();
-    std::cout << "\n------------------------------------------------" << std::endl;
-    std::cout << "Evolution Complete." << std::endl;
+    // Same knobs for one engine or a whole archipelago
+    auto configure = [&](auto& e) {
+        e.set_mode(mode);
+        e.set_target(target);
+        const char* cache_opt = find_option(argc, argv, "--cache");
+        if (cache_opt) e.set_cache_capacity((size_t)std::atoll(cache_opt));
+        e.set_threads(threads);
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--batch") e.set_batch_eval(true);
+            if (std::string(argv[i]) == "--jit") e.set_jit(true);
+            if (std::string(argv[i]) == "--loop-detect") e.set_loop_detection(true);
+            if (std::string(argv[i]) == "--prune") e.set_pruning(true);
+        }
+    };
+    
+    std::cout << "Population: " << population << " | DNA Size: " << dna_size << " bytes | Seed: " << seed << std::endl;
+    Organism best;
+    
+    if (island_count > 1) {
+        if (find_option(argc, argv, "--checkpoint") || find_option(argc, argv, "--resume") ||
+            find_option(argc, argv, "--metrics") || has_flag(argc, argv, "--steady")) {
+            std::cerr << "--checkpoint/--resume/--metrics/--steady only apply to single-population runs; ignoring" << std::endl;
+        }
+        const char* interval_opt = find_option(argc, argv, "--migrate");
+        const char* count_opt = find_option(argc, argv, "--migrants");
+        const char* topology_opt = find_option(argc, argv, "--topology");
+        Topology topology = (topology_opt && std::string(topology_opt) == "random") ? Topology::RANDOM : Topology::RING;
+        
+        IslandModel islands(island_count, population / island_count, dna_size, seed);
+        configure(islands);
+        islands.set_migration(interval_opt ? std::atoi(interval_opt) : 50,
+                              count_opt ? (size_t)std::atoll(count_opt) : 2, topology);
+        std::cout << "Islands: " << island_count << " x " << population / island_count << std::endl;
+        islands.evolve(5000);
+        best = islands.get_best();
+        
+        std::cout << "\n------------------------------------------------" << std::endl;
+        std::cout << "Evolution Complete." << std::endl;
+        for (size_t i = 0; i < islands.island_count(); ++i) {
+            IslandStats s = islands.get_stats(i);
+            std::cout << "Island " << i << " | Gen " << s.generations << " | Best Fitness: " << s.best
+                      << " | Migrants in/out: " << s.migrants_in << "/" << s.migrants_out << std::endl;
+        }
+    } else {
+        DarwinEngine engine(population, dna_size, seed);
+        configure(engine);
+        
+        const char* resume_opt = find_option(argc, argv, "--resume");
+        const char* checkpoint_opt = find_option(argc, argv, "--checkpoint");
+        const char* every_opt = find_option(argc, argv, "--checkpoint-every");
+        if (resume_opt) {
+            if (!engine.load_checkpoint(resume_opt)) return 1;
+            std::cout << "Resumed '" << resume_opt << "' at Gen " << engine.get_generation() << " | Seed: " << engine.get_seed() << std::endl;
+        }
+        if (checkpoint_opt) engine.set_checkpoint(checkpoint_opt, every_opt ? std::atoi(every_opt) : 100);
+        const char* metrics_opt = find_option(argc, argv, "--metrics");
+        if (metrics_opt && !engine.set_metrics(metrics_opt)) {
+            std::cerr << "Metrics: cannot write " << metrics_opt << std::endl;
+            return 1;
+        }
+        
+        const int generations = 5000;
+        if (engine.get_generation() < (uint64_t)generations) {
+            uint64_t remaining = generations - engine.get_generation();
+            if (has_flag(argc, argv, "--steady")) {
+                // Same evaluation budget as the generational run
+                const char* report_opt = find_option(argc, argv, "--report-every");
+                uint64_t report = report_opt ? std::strtoull(report_opt, nullptr, 10) : 100 * (uint64_t)population;
+                engine.evolve_steady(remaining * population, std::max<uint64_t>(report, 1));
+            } else {
+                engine.evolve((int)remaining);
+            }
+        }
+        if (checkpoint_opt && !engine.save_checkpoint(checkpoint_opt)) {
+            std::cerr << "Checkpoint: could not write " << checkpoint_opt << std::endl;
+        }
+        best = engine.get_best();
+        
+        std::cout << "\n------------------------------------------------" << std::endl;
+        std::cout << "Evolution Complete." << std::endl;
+        if (const FitnessCache* cache = engine.get_cache()) {
+            std::cout << "Fitness Cache: " << cache->hits << " hits | " << cache->misses << " misses | "
+                      << cache->evictions << " evictions" << std::endl;
+        }
+        if (metrics_opt) {
+            metrics::collect();
+            metrics::print_summary(std::cout, metrics::totals());
+        }
+    }
     std::cout << "Best DNA (Hex): ";
     for (uint8_t b : best.dna) printf("%02X ", b);
     std::cout << "\nFinal Output: ";
@@ -0,0 +1,133 @@
+#include "metrics.h"
+#include "vm.h"
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <cstring>
+#include <cstdio>
+
+namespace metrics {
+
+void VmCounters::clear() {
+    std::memset(this, 0, sizeof(*this));
+}
+
+void VmCounters::add(const VmCounters& other) {
+    for (int i = 0; i < 256; ++i) opcodes[i] += other.opcodes[i];
+    for (int i = 0; i < HALT_BUCKETS; ++i) halts[i] += other.halts[i];
+    budget_hits += other.budget_hits;
+}
+
+uint64_t VmCounters::instructions() const {
+    uint64_t n = 0;
+    for (int i = 0; i < 256; ++i) n += opcodes[i];
+    return n;
+}
+
+uint64_t VmCounters::halted() const {
+    uint64_t n = 0;
+    for (int i = 0; i < HALT_BUCKETS; ++i) n += halts[i];
+    return n;
+}
+
+namespace {
+
+std::mutex registry_mutex;
+// Never freed: collect() still reads threads that have exited. Held through
+// a pointer so it outlives static destruction and leak checkers still see it.
+std::vector<VmCounters*>& registry = *new std::vector<VmCounters*>();
+VmCounters running_totals;
+
+} // namespace
+
+#if GENESIS_METRICS
+
+VmCounters* register_thread() {
+    VmCounters* c = new VmCounters();
+    c->clear();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(c);
+    return c;
+}
+
+#endif
+
+VmCounters collect() {
+    VmCounters sum;
+    sum.clear();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (VmCounters* c : registry) {
+        sum.add(*c);
+        c->clear();
+    }
+    running_totals.add(sum);
+    return sum;
+}
+
+const VmCounters& totals() {
+    return running_totals;
+}
+
+bool GenerationLog::open(const std::string& path) {
+#if GENESIS_METRICS
+    out.open(path);
+    if (!out) return false;
+    csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        out << "generation,best,mean,evaluated,pruned,fitness_s,sort_s,selection_s,mutation_s,"
+               "instructions,halted,budget_hits\n";
+    }
+    return true;
+#else
+    std::cerr << "Metrics: this build has GENESIS_METRICS=0" << std::endl;
+    (void)path;
+    return false;
+#endif
+}
+
+void GenerationLog::write(const GenerationStats& s) {
+    char line[512];
+    const char* format = csv
+        ? "%llu,%.10g,%.10g,%zu,%zu,%.6f,%.6f,%.6f,%.6f,%llu,%llu,%llu\n"
+        : "{\"generation\":%llu,\"best\":%.10g,\"mean\":%.10g,\"evaluated\":%zu,\"pruned\":%zu,\"fitness_s\":%.6f,"
+          "\"sort_s\":%.6f,\"selection_s\":%.6f,\"mutation_s\":%.6f,\"instructions\":%llu,"
+          "\"halted\":%llu,\"budget_hits\":%llu}\n";
+    snprintf(line, sizeof(line), format, (unsigned long long)s.generation, s.best, s.mean, s.evaluated, s.pruned,
+             s.fitness_s, s.sort_s, s.selection_s, s.mutation_s, (unsigned long long)s.vm.instructions(),
+             (unsigned long long)s.vm.halted(), (unsigned long long)s.vm.budget_hits);
+    out << line << std::flush; // A killed run still leaves its log
+}
+
+void print_summary(std::ostream& out, const VmCounters& c) {
+    static const char* names[] = { "NOP", "INC", "DEC", "ADD", "SUB", "MOV", "LDI", "JMP", "JZ", "IO", "LD", "ST" };
+    uint64_t total = c.instructions();
+    char line[128];
+
+    out << "Opcode mix (" << total << " interpreted instructions):" << std::endl;
+    uint64_t other = 0;
+    for (int op = 0; op < 256; ++op) {
+        const char* name = op <= ST ? names[op] : op == HLT ? "HLT" : nullptr;
+        if (!name) { other += c.opcodes[op]; continue; }
+        snprintf(line, sizeof(line), "  %-6s %14llu  %5.1f%%", name, (unsigned long long)c.opcodes[op],
+                 total ? 100.0 * c.opcodes[op] / total : 0.0);
+        out << line << std::endl;
+    }
+    snprintf(line, sizeof(line), "  %-6s %14llu  %5.1f%%", "other", (unsigned long long)other,
+             total ? 100.0 * other / total : 0.0);
+    out << line << std::endl;
+
+    uint64_t runs = c.halted() + c.budget_hits;
+    out << "Cycles to halt (" << runs << " runs):" << std::endl;
+    for (int k = 0; k < HALT_BUCKETS; ++k) {
+        if (!c.halts[k]) continue;
+        unsigned long long lo = k ? 1ull << (k - 1) : 0, hi = k ? (1ull << k) - 1 : 0;
+        snprintf(line, sizeof(line), "  %8llu-%-8llu %12llu  %5.1f%%", lo, hi, (unsigned long long)c.halts[k],
+                 100.0 * c.halts[k] / runs);
+        out << line << std::endl;
+    }
+    snprintf(line, sizeof(line), "  %-17s %12llu  %5.1f%%", "MAX_CYCLES", (unsigned long long)c.budget_hits,
+             runs ? 100.0 * c.budget_hits / runs : 0.0);
+    out << line << std::endl;
+}
+
+} // namespace metrics
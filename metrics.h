@@ -0,0 +1,118 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+// Runtime instrumentation. Build with GENESIS_METRICS=0 and every hook
+// below compiles to nothing.
+#ifndef GENESIS_METRICS
+#define GENESIS_METRICS 1
+#endif
+
+namespace metrics {
+
+const int HALT_BUCKETS = 24; // Bucket k: halted after [2^(k-1), 2^k) cycles, bucket 0: zero
+
+// What the interpreters did on one thread. Native (JIT) code only reports
+// how its runs ended, not the opcodes it executed.
+struct VmCounters {
+    uint64_t opcodes[256];
+    uint64_t halts[HALT_BUCKETS]; // Runs that reached HLT, by cycles taken
+    uint64_t budget_hits;         // Runs stopped by MAX_CYCLES
+
+    void clear();
+    void add(const VmCounters& other);
+    uint64_t instructions() const;
+    uint64_t halted() const;
+};
+
+#if GENESIS_METRICS
+
+VmCounters* register_thread(); // Counters for a new thread, kept after it exits
+
+inline thread_local VmCounters* thread_counters = nullptr;
+
+inline VmCounters& local() {
+    if (!thread_counters) thread_counters = register_thread();
+    return *thread_counters;
+}
+
+inline int halt_bucket(uint64_t cycles) {
+    int k = 0;
+    while (cycles && k < HALT_BUCKETS - 1) { cycles >>= 1; ++k; }
+    return k;
+}
+
+inline void count_op(uint8_t opcode) { local().opcodes[opcode]++; }
+inline void count_halt(uint64_t cycles) { local().halts[halt_bucket(cycles)]++; }
+inline void count_budget_hit() { local().budget_hits++; }
+
+// Counts from every thread since the last collect, also added to totals().
+// Only call while no VM is running, e.g. between generations.
+VmCounters collect();
+const VmCounters& totals();
+
+// Seconds since construction or the previous call
+class Lap {
+public:
+    double operator()() {
+        auto now = std::chrono::steady_clock::now();
+        double s = std::chrono::duration<double>(now - last).count();
+        last = now;
+        return s;
+    }
+private:
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+};
+
+#else
+
+inline void count_op(uint8_t) {}
+inline void count_halt(uint64_t) {}
+inline void count_budget_hit() {}
+VmCounters collect();
+const VmCounters& totals();
+
+class Lap {
+public:
+    double operator()() { return 0; }
+};
+
+#endif
+
+// One line of the per-generation log
+struct GenerationStats {
+    uint64_t generation;
+    double best;
+    double mean;
+    size_t evaluated;  // Organisms actually scored (the rest came from the cache)
+    size_t pruned;     // Of those, stopped early with only an upper bound (--prune)
+    double fitness_s;  // calculate_fitness
+    double sort_s;
+    double selection_s;
+    double mutation_s;
+    VmCounters vm;     // What scoring executed this generation
+};
+
+// Writes GenerationStats as CSV when the file name ends in ".csv", JSON
+// lines otherwise
+class GenerationLog {
+public:
+    bool open(const std::string& path);
+    void write(const GenerationStats& s);
+
+private:
+    std::ofstream out;
+    bool csv = false;
+};
+
+// Opcode mix and cycles-to-halt histogram, for the end of a run
+void print_summary(std::ostream& out, const VmCounters& c);
+
+} // namespace metrics
+
+#endif
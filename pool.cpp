@@ -0,0 +1,130 @@
+#include "pool.h"
+#include <algorithm>
+
+static const size_t CHUNK = 8; // Indices grabbed per atomic fetch
+
+WorkerPool::WorkerPool(unsigned count) : worker_count(std::max(1u, count)) {
+    for (unsigned id = 0; id < worker_count; ++id) {
+        queues.emplace_back(new Queue());
+    }
+    for (unsigned id = 1; id < worker_count; ++id) {
+        threads.emplace_back(&WorkerPool::worker_loop, this, id);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::worker_loop(unsigned id) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        wake.wait(lock, [&] { return stopping || job_id != seen; });
+        if (stopping) return;
+        seen = job_id;
+
+        lock.unlock();
+        (*body)(id);
+        lock.lock();
+
+        if (--active == 0) done.notify_all();
+    }
+}
+
+// Runs fn on every worker, the caller included, and waits for all of them
+void WorkerPool::dispatch(const std::function<void(unsigned)>& fn) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        body = &fn;
+        active = worker_count - 1;
+        ++job_id;
+    }
+    wake.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    done.wait(lock, [&] { return active == 0; });
+    body = nullptr;
+}
+
+void WorkerPool::run_chunks(unsigned id) {
+    for (;;) {
+        size_t begin = next_index.fetch_add(CHUNK, std::memory_order_relaxed);
+        if (begin >= job_size) return;
+        size_t end = std::min(begin + CHUNK, job_size);
+        for (size_t i = begin; i < end; ++i) (*job)(i, id);
+    }
+}
+
+void WorkerPool::parallel_for(size_t n, const std::function<void(size_t, unsigned)>& fn) {
+    if (worker_count == 1 || n <= CHUNK) {
+        for (size_t i = 0; i < n; ++i) fn(i, 0);
+        return;
+    }
+
+    job = &fn;
+    job_size = n;
+    next_index.store(0, std::memory_order_relaxed);
+    dispatch([this](unsigned id) { run_chunks(id); });
+    job = nullptr;
+}
+
+// Own deque from the front, then the back of every other worker's deque
+bool WorkerPool::take(unsigned id, Task& out) {
+    {
+        Queue& q = *queues[id];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (!q.tasks.empty()) {
+            out = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    for (unsigned k = 1; k < worker_count; ++k) {
+        Queue& q = *queues[(id + k) % worker_count];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (!q.tasks.empty()) {
+            out = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run_stealing(unsigned id) {
+    Task task;
+    while (unfinished.load(std::memory_order_acquire) > 0) {
+        if (take(id, task)) {
+            task(id);
+            task = nullptr;
+            unfinished.fetch_sub(1, std::memory_order_acq_rel);
+        } else {
+            std::this_thread::yield(); // Everything left is running elsewhere
+        }
+    }
+}
+
+void WorkerPool::submit(unsigned worker, Task task) {
+    // Counted before the parent task finishes, so `unfinished` cannot touch 0 early
+    unfinished.fetch_add(1, std::memory_order_relaxed);
+    Queue& q = *queues[worker];
+    std::lock_guard<std::mutex> lock(q.lock);
+    q.tasks.push_back(std::move(task));
+}
+
+void WorkerPool::run_tasks(std::vector<Task> tasks) {
+    unfinished.store(tasks.size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        queues[i % worker_count]->tasks.push_back(std::move(tasks[i]));
+    }
+    if (worker_count == 1) run_stealing(0);
+    else dispatch([this](unsigned id) { run_stealing(id); });
+}
@@ -0,0 +1,74 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+// Fixed set of worker threads for data-parallel loops and task graphs.
+// The calling thread joins in as worker 0, so a pool of size 1 spawns nothing.
+class WorkerPool {
+public:
+    typedef std::function<void(unsigned)> Task; // Receives the id of the worker running it
+
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return worker_count; }
+
+    // Calls fn(index, worker_id) for every index in [0, n) and blocks until all are done.
+    // Indices are handed out in small chunks, so uneven work still balances.
+    void parallel_for(size_t n, const std::function<void(size_t, unsigned)>& fn);
+
+    // Runs tasks (and everything they submit) on a work-stealing scheduler
+    // and blocks until all are done. Each worker runs its own deque in FIFO
+    // order, so requeued tasks take turns, and steals from the other end of
+    // another worker's deque when it runs dry.
+    void run_tasks(std::vector<Task> tasks);
+
+    // Queues a follow-up task on `worker`'s deque. Only valid from inside a
+    // task started by run_tasks, with the id that task was given.
+    void submit(unsigned worker, Task task);
+
+private:
+    unsigned worker_count;
+    std::vector<std::thread> threads;
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+    uint64_t job_id = 0;
+    unsigned active = 0;
+    const std::function<void(unsigned)>* body = nullptr; // What every worker runs for the current job
+
+    // parallel_for
+    const std::function<void(size_t, unsigned)>* job = nullptr;
+    size_t job_size = 0;
+    std::atomic<size_t> next_index{0};
+
+    // run_tasks
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<size_t> unfinished{0}; // Submitted but not yet completed
+
+    void worker_loop(unsigned id);
+    void dispatch(const std::function<void(unsigned)>& fn);
+    void run_chunks(unsigned id);
+    void run_stealing(unsigned id);
+    bool take(unsigned id, Task& out);
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "replay.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+size_t keyframe_bytes(const BattleLogHeader& h) {
+    return 4 + (size_t)h.warriors * 12 + 2 * h.core_size;
+}
+} // namespace
+
+// --- Recorder ---
+
+BattleRecorder::BattleRecorder(int keyframe_interval) : requested_interval(keyframe_interval) {}
+
+BattleRecorder::~BattleRecorder() {
+    if (file) std::fclose(file);
+}
+
+bool BattleRecorder::open(const std::string& p) {
+    if (file) std::fclose(file);
+    path = p;
+    file = std::fopen(p.c_str(), "wb");
+    buffer.clear();
+    flushed = 0;
+    keyframes.clear();
+    failed = false;
+    return file != nullptr;
+}
+
+void BattleRecorder::begin(int word_bytes, const std::vector<uint8_t>& memory, const std::vector<uint8_t>& owner,
+                           const std::vector<size_t>& start) {
+    if (!file) return;
+    interval = requested_interval > 0 ? requested_interval : (int)std::max<size_t>(1024, memory.size() / 4);
+    BattleLogHeader h;
+    std::memcpy(h.magic, BATTLE_LOG_MAGIC, sizeof(h.magic));
+    h.version = BATTLE_LOG_VERSION;
+    h.word_bytes = word_bytes;
+    h.core_size = memory.size();
+    h.warriors = (uint32_t)start.size();
+    h.keyframe_interval = interval;
+    put(&h, sizeof(h));
+
+    ips = start;
+    died.assign(start.size(), -1);
+    round = 0;
+    store_pending = false;
+    keyframe(memory, owner);
+}
+
+void BattleRecorder::keyframe(const std::vector<uint8_t>& memory, const std::vector<uint8_t>& owner) {
+    keyframes.push_back(flushed + buffer.size());
+    uint32_t r = round;
+    put(&r, sizeof(r));
+    for (size_t k = 0; k < ips.size(); ++k) {
+        uint64_t at = ips[k];
+        int32_t d = died[k];
+        put(&at, sizeof(at));
+        put(&d, sizeof(d));
+    }
+    put(memory.data(), memory.size());
+    put(owner.data(), owner.size());
+    last_store.assign(ips.size(), 0);
+}
+
+void BattleRecorder::on_store(void* recorder, size_t addr, uint8_t value) {
+    BattleRecorder* r = (BattleRecorder*)recorder;
+    r->store_pending = true;
+    r->store_addr = addr;
+    r->store_value = value;
+}
+
+void BattleRecorder::stepped(size_t warrior, size_t ip, bool halted) {
+    if (!file) {
+        store_pending = false;
+        return;
+    }
+    uint64_t head = zigzag((int64_t)ip - (int64_t)ips[warrior]) << 2;
+    put_varint(head | (halted ? 2 : 0) | (store_pending ? 1 : 0));
+    if (store_pending) {
+        put_varint(zigzag((int64_t)store_addr - (int64_t)last_store[warrior]));
+        put(&store_value, 1);
+        last_store[warrior] = store_addr;
+        store_pending = false;
+    }
+    ips[warrior] = ip;
+    if (halted) died[warrior] = round + 1;
+}
+
+void BattleRecorder::end_round(int r, const std::vector<uint8_t>& memory, const std::vector<uint8_t>& owner) {
+    if (!file) return;
+    round = r;
+    if (round % interval == 0) keyframe(memory, owner);
+    if (buffer.size() >= (1 << 16)) flush();
+}
+
+bool BattleRecorder::finish(const BattleResult& result) {
+    if (!file) return false;
+    BattleLogFooter f;
+    f.index_offset = flushed + buffer.size();
+    f.rounds = result.cycles;
+    f.winner = result.winner;
+    f.keyframes = (uint32_t)keyframes.size();
+    f.reserved = 0;
+    std::memcpy(f.magic, BATTLE_LOG_MAGIC, sizeof(f.magic));
+    put(keyframes.data(), keyframes.size() * sizeof(uint64_t));
+    put(&f, sizeof(f));
+    flush();
+
+    bool ok = !failed && std::fclose(file) == 0;
+    file = nullptr;
+    if (!ok) std::cerr << "Replay: could not write " << path << std::endl;
+    return ok;
+}
+
+void BattleRecorder::put_varint(uint64_t v) {
+    while (v >= 0x80) {
+        buffer.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    buffer.push_back((uint8_t)v);
+}
+
+void BattleRecorder::put(const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    buffer.insert(buffer.end(), p, p + n);
+}
+
+void BattleRecorder::flush() {
+    if (buffer.empty()) return;
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) failed = true;
+    flushed += buffer.size();
+    buffer.clear();
+}
+
+// --- Player ---
+
+bool BattlePlayer::open(const std::string& path) {
+    if (!file.open(path)) {
+        std::cerr << "Replay: cannot open " << path << std::endl;
+        return false;
+    }
+    if (file.size() < sizeof(header) + sizeof(footer)) {
+        std::cerr << "Replay: " << path << " is not a battle log" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    std::memcpy(&footer, file.data() + file.size() - sizeof(footer), sizeof(footer));
+    if (std::memcmp(header.magic, BATTLE_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BATTLE_LOG_VERSION || header.warriors == 0 || header.warriors > 255 || header.core_size == 0 ||
+        header.keyframe_interval == 0) {
+        std::cerr << "Replay: " << path << " is not a battle log" << std::endl;
+        return false;
+    }
+    if (std::memcmp(footer.magic, BATTLE_LOG_MAGIC, sizeof(footer.magic)) != 0 || footer.keyframes == 0 ||
+        footer.index_offset + footer.keyframes * sizeof(uint64_t) + sizeof(footer) != file.size()) {
+        std::cerr << "Replay: " << path << " is incomplete (the battle never finished)" << std::endl;
+        return false;
+    }
+
+    index.resize(footer.keyframes);
+    std::memcpy(index.data(), file.data() + footer.index_offset, footer.keyframes * sizeof(uint64_t));
+    for (uint64_t at : index) {
+        if (at < sizeof(header) || at + keyframe_bytes(header) > footer.index_offset) {
+            std::cerr << "Replay: " << path << " has a damaged keyframe index" << std::endl;
+            return false;
+        }
+    }
+    return load_keyframe(0);
+}
+
+bool BattlePlayer::load_keyframe(size_t k) {
+    const uint8_t* p = file.data() + index[k];
+    uint32_t r;
+    std::memcpy(&r, p, sizeof(r));
+    p += sizeof(r);
+    ip.resize(header.warriors);
+    died_at.resize(header.warriors);
+    for (size_t w = 0; w < header.warriors; ++w) {
+        uint64_t at;
+        int32_t d;
+        std::memcpy(&at, p, sizeof(at));
+        std::memcpy(&d, p + sizeof(at), sizeof(d));
+        p += sizeof(at) + sizeof(d);
+        ip[w] = (size_t)at;
+        died_at[w] = d;
+    }
+    core.assign(p, p + header.core_size);
+    p += header.core_size;
+    owner.assign(p, p + header.core_size);
+    owned.assign(256, 0);
+    for (uint8_t o : owner) owned[o]++;
+    last_store.assign(header.warriors, 0);
+    current = (int)r;
+    pos = index[k] + keyframe_bytes(header);
+    return true;
+}
+
+bool BattlePlayer::get_varint(uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < footer.index_offset; shift += 7) {
+        uint8_t b = file.data()[pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool BattlePlayer::next() {
+    if (current >= (int)footer.rounds) return false;
+    for (size_t w = 0; w < header.warriors; ++w) {
+        if (died_at[w] >= 0) continue;
+        uint64_t head;
+        if (!get_varint(head)) goto damaged;
+        ip[w] = (size_t)((int64_t)ip[w] + unzigzag(head >> 2));
+        if (head & 2) died_at[w] = current + 1;
+        if (head & 1) {
+            uint64_t delta;
+            if (!get_varint(delta) || pos >= footer.index_offset) goto damaged;
+            size_t addr = (size_t)((int64_t)last_store[w] + unzigzag(delta));
+            if (addr >= core.size()) goto damaged;
+            core[addr] = file.data()[pos++];
+            owned[owner[addr]]--;
+            owned[w + 1]++;
+            owner[addr] = (uint8_t)(w + 1);
+            last_store[w] = addr;
+        }
+    }
+    current++;
+
+    // Keyframes restart the ST address deltas; the state itself already matches
+    if (current % header.keyframe_interval == 0) {
+        size_t k = current / header.keyframe_interval;
+        if (k >= index.size() || index[k] != pos) goto damaged;
+        load_keyframe(k);
+    }
+    return true;
+
+damaged:
+    std::cerr << "Replay: damaged log at byte " << pos << std::endl;
+    return false;
+}
+
+bool BattlePlayer::seek(int target) {
+    target = std::max(0, std::min(target, (int)footer.rounds));
+    size_t k = std::min((size_t)target / header.keyframe_interval, index.size() - 1);
+    int base = (int)(k * header.keyframe_interval);
+    // Going forward from here is never slower than from the keyframe
+    if (current > target || current < base) load_keyframe(k);
+    while (current < target) {
+        if (!next()) return false;
+    }
+    return true;
+}
@@ -0,0 +1,131 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include "arena.h"
+#include "checkpoint.h"
+
+// Recorded Arena battle (native endianness):
+//
+//   BattleLogHeader
+//   keyframe 0, then after every keyframe_interval rounds another one:
+//       uint32 round, per warrior { uint64 ip, int32 died }, memory[core_size],
+//       owner[core_size] (warrior number that wrote each cell last, 0 = nobody)
+//   one record per round, per warrior still alive when the round began:
+//       varint zigzag(ip - previous ip) << 2 | died << 1 | stored
+//       if stored: varint zigzag(addr - that warrior's previous ST address), uint8 value
+//   uint64 keyframe offsets[keyframes]
+//   BattleLogFooter
+//
+// Varints are LEB128. Previous ST addresses restart at 0 after every
+// keyframe, so decoding can start at any of them. A typical round costs a
+// byte or two per warrior. A store always makes the cell its warrior's.
+const char BATTLE_LOG_MAGIC[8] = { 'G', 'E', 'N', 'E', 'S', 'I', 'S', 'B' };
+const uint32_t BATTLE_LOG_VERSION = 2; // 2: keyframes carry the ownership map
+
+struct BattleLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t word_bytes;
+    uint64_t core_size;
+    uint32_t warriors;
+    uint32_t keyframe_interval;
+};
+
+struct BattleLogFooter {
+    uint64_t index_offset; // Where the keyframe offsets start
+    uint32_t rounds;
+    int32_t winner;        // As in BattleResult
+    uint32_t keyframes;
+    uint32_t reserved;
+    char magic[8];
+};
+
+// Writes one battle per file. Attach it with BasicArena::set_recorder
+// before load_warriors(); the Arena then feeds it every round and calls
+// finish() once the battle is judged.
+class BattleRecorder {
+public:
+    // 0 = every 1024 rounds, or every core_size / 4 rounds on big cores,
+    // so keyframes never cost more than 8 bytes a round
+    explicit BattleRecorder(int keyframe_interval = 0);
+    ~BattleRecorder();
+    BattleRecorder(const BattleRecorder&) = delete;
+    BattleRecorder& operator=(const BattleRecorder&) = delete;
+
+    bool open(const std::string& path);
+    bool is_open() const { return file != nullptr; }
+
+    void begin(int word_bytes, const std::vector<uint8_t>& memory, const std::vector<uint8_t>& owner,
+               const std::vector<size_t>& ips);
+    static void on_store(void* recorder, size_t addr, uint8_t value); // VM store_hook
+    void stepped(size_t warrior, size_t ip, bool died); // After each warrior's step
+    void end_round(int round, const std::vector<uint8_t>& memory, const std::vector<uint8_t>& owner);
+    bool finish(const BattleResult& result); // Writes the index and closes the file
+
+private:
+    FILE* file = nullptr;
+    std::string path;
+    int requested_interval;
+    int interval = 1;
+    int round = 0;
+    std::vector<uint8_t> buffer; // Pending bytes
+    uint64_t flushed = 0;        // Bytes already in the file
+    std::vector<uint64_t> keyframes;
+    std::vector<size_t> ips;
+    std::vector<int> died;
+    std::vector<size_t> last_store;
+    bool store_pending = false;
+    size_t store_addr = 0;
+    uint8_t store_value = 0;
+    bool failed = false;
+
+    void keyframe(const std::vector<uint8_t>& memory, const std::vector<uint8_t>& owner);
+    void put_varint(uint64_t v);
+    void put(const void* data, size_t n);
+    void flush();
+};
+
+// Reads a recorded battle back without running any VM: rounds are applied
+// from the log, and seek() jumps to the nearest keyframe first.
+class BattlePlayer {
+public:
+    bool open(const std::string& path);
+
+    int rounds() const { return footer.rounds; }
+    int winner() const { return footer.winner; }
+    int word_bytes() const { return header.word_bytes; }
+    int round() const { return current; } // Rounds applied so far
+
+    const std::vector<uint8_t>& memory() const { return core; }
+    const std::vector<size_t>& ips() const { return ip; }
+    const std::vector<int>& died() const { return died_at; } // Round each warrior halted in, -1 while alive
+    const std::vector<uint8_t>& ownership() const { return owner; } // As BasicArena::ownership()
+    size_t territory(size_t k) const { return owned[k + 1]; }
+
+    bool next();          // Applies one round; false at the end or on a damaged log
+    bool seek(int round); // State after `round` (clamped to the battle)
+
+private:
+    MappedFile file;
+    BattleLogHeader header;
+    BattleLogFooter footer;
+    std::vector<uint64_t> index;
+    size_t pos = 0;
+    int current = 0;
+    std::vector<uint8_t> core;
+    std::vector<size_t> ip;
+    std::vector<int> died_at;
+    std::vector<uint8_t> owner;
+    std::vector<size_t> owned; // Cells per owner id, recounted at each keyframe
+    std::vector<size_t> last_store;
+
+    bool load_keyframe(size_t k);
+    bool get_varint(uint64_t& v);
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include "server.h"
+#include "bio.h"
+#include "fitness_cache.h"
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SERVER_SOCKETS 1
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstring>
+#endif
+
+namespace {
+// Replies held back for ordering stop the reader at this many jobs in flight
+const uint64_t MAX_IN_FLIGHT = 4096;
+// Replies written but not flushed; the pipeline draining flushes too
+const int FLUSH_EVERY = 64;
+
+bool read_line(FILE* in, std::string& line) {
+    line.clear();
+    char chunk[4096];
+    while (std::fgets(chunk, sizeof(chunk), in)) {
+        line += chunk;
+        if (line.back() == '\n') break;
+    }
+    if (line.empty()) return false;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+    return true;
+}
+
+// Words split on spaces, with the offset each one starts at
+std::vector<std::string> split(const std::string& line, std::vector<size_t>& starts) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (true) {
+        i = line.find_first_not_of(" \t", i);
+        if (i == std::string::npos) break;
+        size_t end = std::min(line.find_first_of(" \t", i), line.size());
+        starts.push_back(i);
+        words.push_back(line.substr(i, end - i));
+        i = end;
+    }
+    return words;
+}
+
+bool known_mode(const std::string& name) {
+    return name == "string" || name == "math" || name == "survival" || name == "consciousness";
+}
+
+std::string join(const std::vector<int>& v) {
+    std::string s;
+    for (size_t i = 0; i < v.size(); ++i) s += (i ? "," : "") + std::to_string(v[i]);
+    return s;
+}
+} // namespace
+
+JobServer::JobServer(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    pool.reset(new WorkerPool(threads));
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(new Worker());
+        workers.back()->arena.reset(new Arena(core_size));
+        workers.back()->arena->set_cycle_budget(cycle_budget);
+    }
+}
+
+void JobServer::set_decisive_share(double share) {
+    decisive_share = share;
+    for (auto& w : workers) w->arena->set_decisive_share(share);
+}
+
+void JobServer::set_cycles(int n) {
+    cycles = n;
+}
+
+void JobServer::set_cycle_budget(int n) {
+    cycle_budget = n;
+    for (auto& w : workers) w->arena->set_cycle_budget(n);
+}
+
+void JobServer::set_core_size(size_t n) {
+    core_size = std::max<size_t>(1, std::min(n, Arena::MAX_CORE));
+    for (auto& w : workers) {
+        w->arena.reset(new Arena(core_size));
+        w->arena->set_cycle_budget(cycle_budget);
+        w->arena->set_decisive_share(decisive_share);
+    }
+}
+
+void JobServer::set_jit(bool on) {
+    use_jit = on;
+}
+
+void JobServer::set_seed(uint64_t s) {
+    seed = s;
+}
+
+std::string JobServer::run_job(const std::string& line, Worker& w) {
+    std::vector<size_t> starts;
+    std::vector<std::string> args = split(line, starts);
+    const std::string& command = args[0];
+
+    if (command == "decode") {
+        if (args.size() != 2) return "err usage: decode <DNA>";
+        static const char hex[] = "0123456789ABCDEF";
+        std::string reply = "ok ";
+        for (uint8_t b : BioCompiler::decode(args[1])) {
+            reply += hex[b >> 4];
+            reply += hex[b & 15];
+        }
+        return reply;
+    }
+    if (command == "score") {
+        if (args.size() < 3) return "err usage: score <mode> <DNA> [target]";
+        std::string target;
+        if (args.size() > 3) target = line.substr(starts[3]);
+        return score(args, target, w);
+    }
+    if (command == "battle") return battle(args, w);
+    return "err unknown job '" + command + "'";
+}
+
+std::string JobServer::score(const std::vector<std::string>& args, const std::string& target, Worker& w) {
+    if (!known_mode(args[1])) return "err unknown mode '" + args[1] + "'";
+    const FitnessMode& mode = fitness_mode(args[1]);
+    std::vector<uint8_t> dna = BioCompiler::decode(args[2]);
+    if (dna.size() > w.ws.vm.mem_size) return "err DNA too long";
+
+    // Same genome, same radiation: survival scores repeat across runs
+    uint64_t key = FitnessCache::hash(dna.data(), dna.size()) ^ seed;
+    uint32_t stream_seed = (uint32_t)(key ^ (key >> 32));
+
+    ScoreOptions options;
+    options.jit = use_jit;
+    double fitness = score_genome(mode, options, dna, w.ws, target, stream_seed);
+    char reply[64];
+    std::snprintf(reply, sizeof(reply), "ok %.17g", fitness);
+    return reply;
+}
+
+std::string JobServer::battle(const std::vector<std::string>& args, Worker& w) {
+    if (args.size() < 3) return "err usage: battle <warrior> <warrior> [...]";
+    if (args.size() - 1 > Arena::MAX_WARRIORS) return "err at most " + std::to_string(Arena::MAX_WARRIORS) + " warriors";
+    std::vector<std::vector<uint8_t>> programs;
+    for (size_t i = 1; i < args.size(); ++i) {
+        int tag = BioCompiler::width_tag(args[i]);
+        if (tag && tag != Arena::WORD_BYTES) return "err warrior " + std::to_string(i) + " is " + std::to_string(8 * tag) + "-bit DNA";
+        std::vector<uint8_t> code = builtin_warrior(args[i], Arena::WORD_BYTES);
+        if (code.empty()) code = BioCompiler::decode(args[i]);
+        if (code.empty()) return "err warrior " + std::to_string(i) + " has no code";
+        programs.push_back(code);
+    }
+    if (programs.size() > core_size) return "err too many warriors for the core";
+
+    w.arena->load_warriors(programs);
+    BattleResult r = w.arena->simulate(cycles);
+    return "ok " + std::to_string(r.winner) + " " + std::to_string(r.cycles) + " " + join(r.survival) + " " +
+           join(r.territory);
+}
+
+bool JobServer::serve(FILE* in, FILE* out) {
+    struct Job { uint64_t seq; std::string line; };
+
+    std::mutex lock;                // Guards the queue
+    std::condition_variable work;   // A job was queued, or input ended
+    std::condition_variable room;   // Replies were written
+    std::deque<Job> queue;
+    bool eof = false;
+    std::atomic<uint64_t> read{0};  // Jobs queued so far
+
+    std::mutex out_lock;            // Guards the replies and `out`
+    std::map<uint64_t, std::string> ready; // Finished, waiting for earlier jobs
+    std::atomic<uint64_t> written{0};
+    int unflushed = 0;
+    bool failed = false;
+
+    // Reads ahead while workers run, so jobs overlap with I/O
+    std::thread reader([&] {
+        std::string line;
+        while (read_line(in, line)) {
+            if (line.find_first_not_of(" \t") == std::string::npos) continue;
+            std::unique_lock<std::mutex> g(lock);
+            room.wait(g, [&] { return read - written < MAX_IN_FLIGHT; });
+            queue.push_back(Job{ read++, line });
+            work.notify_one();
+        }
+        std::lock_guard<std::mutex> g(lock);
+        eof = true;
+        work.notify_all();
+    });
+
+    // Whoever finishes the job next in line writes it and anything queued behind it
+    auto deliver = [&](uint64_t seq, std::string reply) {
+        {
+            std::lock_guard<std::mutex> o(out_lock);
+            ready.emplace(seq, std::move(reply));
+            if (ready.begin()->first != written) return;
+            uint64_t queued = read;
+            while (!ready.empty() && ready.begin()->first == written) {
+                const std::string& r = ready.begin()->second;
+                if (std::fwrite(r.data(), 1, r.size(), out) != r.size() || std::fputc('\n', out) == EOF) failed = true;
+                ready.erase(ready.begin());
+                written++;
+                unflushed++;
+            }
+            // Flush once the client has every reply it can be waiting for
+            if (written == queued || unflushed >= FLUSH_EVERY) {
+                if (std::fflush(out) != 0) failed = true;
+                unflushed = 0;
+            }
+        }
+        std::lock_guard<std::mutex> g(lock);
+        room.notify_one();
+    };
+
+    std::vector<WorkerPool::Task> tasks;
+    for (unsigned t = 0; t < pool->size(); ++t) {
+        tasks.push_back([&](unsigned id) {
+            Worker& w = *workers[id];
+            while (true) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> g(lock);
+                    work.wait(g, [&] { return !queue.empty() || eof; });
+                    if (queue.empty()) return;
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                }
+                deliver(job.seq, run_job(job.line, w));
+            }
+        });
+    }
+    pool->run_tasks(std::move(tasks));
+    reader.join();
+
+    if (std::fflush(out) != 0) failed = true;
+    completed += written;
+    return !failed;
+}
+
+bool JobServer::serve_socket(const std::string& path) {
+#if SERVER_SOCKETS
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Serve: socket path too long: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str()); // Left behind by an earlier server
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+        std::cerr << "Serve: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        if (listener >= 0) close(listener);
+        return false;
+    }
+    std::signal(SIGPIPE, SIG_IGN); // A client hanging up must not end the server
+    std::cerr << "Serve: listening on " << path << std::endl;
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Serve: accept failed: " << std::strerror(errno) << std::endl;
+            close(listener);
+            return false;
+        }
+        FILE* in = fdopen(client, "r");
+        FILE* out = in ? fdopen(dup(client), "w") : nullptr;
+        if (in && out) serve(in, out);
+        else std::cerr << "Serve: cannot open client stream" << std::endl;
+        if (out) std::fclose(out);
+        if (in) std::fclose(in);
+        else close(client);
+    }
+#else
+    std::cerr << "Serve: --socket needs a POSIX system (" << path << "); use stdin instead" << std::endl;
+    return false;
+#endif
+}
@@ -0,0 +1,65 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include "fitness.h"
+#include "arena.h"
+#include "pool.h"
+
+// Long-running batch mode: reads one job per line and writes one reply
+// line per job, in the order the jobs arrived. Jobs run on the pool as soon
+// as they are read, so a client may keep many in flight and read replies
+// as they come.
+//
+//   decode <DNA>                         -> ok <hex bytecode>
+//   score <mode> <DNA> [target]          -> ok <fitness>
+//   battle <warrior> <warrior> [...]     -> ok <winner> <rounds> <survival,...> <territory,...>
+//
+// A warrior is DNA or a built-in name (bomber, runner, replicator), and
+// battles are 16-bit like Arena's. The target is the rest of the line.
+// Failures answer "err <reason>"; blank lines get no reply.
+class JobServer {
+public:
+    explicit JobServer(unsigned threads); // 0 = all cores
+
+    void set_cycles(int n);        // Rounds per battle (default 5000)
+    void set_cycle_budget(int n);  // Instructions per warrior (default 1000)
+    void set_core_size(size_t n);  // Arena bytes (default 1024, at most 64 KB)
+    void set_decisive_share(double share); // End battles early (Arena::set_decisive_share)
+    void set_jit(bool on);         // Compile deterministic genomes to native code
+    void set_seed(uint64_t s);     // Mixed into the radiation stream of survival scoring
+
+    // Until `in` runs dry; false if replies could not be written
+    bool serve(FILE* in, FILE* out);
+    // Accepts clients on a Unix socket at `path`, one after another, and
+    // never returns unless the socket can't be set up (POSIX only)
+    bool serve_socket(const std::string& path);
+
+    uint64_t jobs_done() const { return completed; }
+
+private:
+    struct Worker {
+        WorkerState ws;
+        std::unique_ptr<Arena> arena;
+    };
+
+    std::unique_ptr<WorkerPool> pool;
+    std::vector<std::unique_ptr<Worker>> workers; // One per pool thread
+    int cycles = 5000;
+    int cycle_budget = 1000;
+    size_t core_size = Arena::DEFAULT_CORE;
+    double decisive_share = 0;
+    bool use_jit = false;
+    uint64_t seed = 0;
+    uint64_t completed = 0;
+
+    std::string run_job(const std::string& line, Worker& w);
+    std::string score(const std::vector<std::string>& args, const std::string& target, Worker& w);
+    std::string battle(const std::vector<std::string>& args, Worker& w);
+};
+
+#endif
@@ -0,0 +1,749 @@
+// Self-checks for the fast paths: each one is compared against the plain
+// version it replaces, or against itself on another route (thread count,
+// checkpoint, replay). Run all with `genesis_tests`, or only those whose
+// name contains one of the arguments.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <atomic>
+#include <memory>
+#include <new>
+#include "vm.h"
+#include "jit.h"
+#include "bio.h"
+#include "rng.h"
+#include "fitness.h"
+#include "darwin.h"
+#include "checkpoint.h"
+#include "arena.h"
+#include "replay.h"
+#include "server.h"
+#include "islands.h"
+
+// --- Allocation counting ---
+
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t n) {
+    allocations++;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+// --- Harness ---
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        if (++failures <= 20) std::printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+static std::vector<uint8_t> random_bytes(CounterRng& rng, size_t n) {
+    std::vector<uint8_t> v(n);
+    for (auto& x : v) x = (uint8_t)rng.next();
+    return v;
+}
+
+// Random genome leaning on real opcodes, so loops, branches and stores happen
+static std::vector<uint8_t> random_genome(CounterRng& rng, size_t n) {
+    std::vector<uint8_t> v(n);
+    for (auto& x : v) x = rng.below(3) ? (uint8_t)rng.below(12) : (uint8_t)rng.next();
+    return v;
+}
+
+template <typename VM>
+static bool same_state(const VM& a, const VM& b) {
+    return std::memcmp(a.memory, b.memory, a.mem_size) == 0 &&
+           std::memcmp(a.registers, b.registers, sizeof(a.registers)) == 0 &&
+           a.ip == b.ip && a.halted == b.halted && a.instructions_executed == b.instructions_executed &&
+           a.output_buffer.size() == b.output_buffer.size() &&
+           a.output_buffer.stored() == b.output_buffer.stored() &&
+           std::memcmp(a.output_buffer.data(), b.output_buffer.data(), a.output_buffer.stored()) == 0;
+}
+
+template <typename VM>
+static void step_to_end(VM& vm) {
+    while (!vm.halted) vm.step();
+}
+
+// --- BioCompiler ---
+
+// decode() as it was before the table/SSE2 rewrite
+static std::vector<uint8_t> reference_decode(const std::string& dna) {
+    std::vector<uint8_t> data;
+    size_t start = dna.find("ATG");
+    if (start == std::string::npos) start = 0; else start += 3;
+    size_t end = dna.rfind("TAA");
+    if (end == std::string::npos) end = dna.length();
+    uint8_t current = 0;
+    int bits = 0;
+    for (size_t i = start; i < end; ++i) {
+        uint8_t val;
+        switch (dna[i]) {
+            case 'A': val = 0; break;
+            case 'C': val = 1; break;
+            case 'G': val = 2; break;
+            case 'T': val = 3; break;
+            default: continue;
+        }
+        current = (uint8_t)(current << 2 | val);
+        bits += 2;
+        if (bits == 8) {
+            data.push_back(current);
+            current = 0;
+            bits = 0;
+        }
+    }
+    return data;
+}
+
+static void test_bio_decode() {
+    const char alphabet[] = "ACGTACGTACGTACGTNn -\nxacgt";
+    for (int t = 0; t < 3000; ++t) {
+        CounterRng rng(1, t, 0, 0);
+        std::string dna;
+        size_t n = rng.below(t < 100 ? 40 : 400);
+        int noise = rng.below(4); // Some inputs are almost clean, so the 16-base path runs
+        for (size_t i = 0; i < n; ++i) {
+            dna += rng.below(8) < (unsigned)noise ? alphabet[rng.below(sizeof(alphabet) - 1)] : "ACGT"[rng.below(4)];
+        }
+        CHECK(BioCompiler::decode(dna) == reference_decode(dna));
+
+        std::istringstream in(dna);
+        std::ostringstream out;
+        CHECK(BioCompiler::decode_stream(in, out));
+        std::string bytes = out.str();
+        CHECK(std::vector<uint8_t>(bytes.begin(), bytes.end()) == reference_decode(dna));
+    }
+}
+
+static void test_bio_round_trip() {
+    for (int t = 0; t < 200; ++t) {
+        CounterRng rng(2, t, 0, 0);
+        std::vector<uint8_t> data = random_bytes(rng, rng.below(300));
+        CHECK(BioCompiler::decode(BioCompiler::encode(data)) == data);
+        std::string tagged = BioCompiler::tag_width(BioCompiler::encode(data), 1 << (t % 3));
+        CHECK(BioCompiler::width_tag(tagged) == 1 << (t % 3) && BioCompiler::decode(tagged) == data);
+        CHECK(BioCompiler::width_tag(BioCompiler::encode(data)) == 0);
+
+        std::istringstream in(std::string(data.begin(), data.end()));
+        std::ostringstream dna;
+        CHECK(BioCompiler::encode_stream(in, dna));
+        CHECK(BioCompiler::decode(dna.str()) == data);
+    }
+}
+
+// --- VM fast paths against step() ---
+
+static void test_vm_decoded() {
+    for (int t = 0; t < 20000; ++t) {
+        CounterRng rng(3, t, 0, 0);
+        std::vector<uint8_t> dna = random_genome(rng, 16 + rng.below(100));
+        CellVM fast, slow;
+        for (CellVM* vm : { &fast, &slow }) {
+            vm->load_program(dna);
+            vm->registers[0] = (uint8_t)rng.below(4);
+            vm->registers[1] = (uint8_t)rng.below(4);
+        }
+        slow.registers[0] = fast.registers[0];
+        slow.registers[1] = fast.registers[1];
+        fast.detect_cycles = t & 1; // Fast-forwarding must land on the same final state
+        fast.run();
+        step_to_end(slow);
+        CHECK(same_state(fast, slow));
+    }
+}
+
+static void test_vm_jit() {
+    if (!JitProgram::supported()) {
+        std::printf("  (no JIT on this platform)\n");
+        return;
+    }
+    JitProgram jit;
+    for (int t = 0; t < 20000; ++t) {
+        CounterRng rng(4, t, 0, 0);
+        std::vector<uint8_t> dna = random_genome(rng, 16 + rng.below(100));
+        CellVM native, slow;
+        native.load_program(dna);
+        slow.load_program(dna);
+        native.registers[0] = slow.registers[0] = (uint8_t)rng.below(4);
+        CHECK(jit.compile(native));
+        jit.run(native);
+        step_to_end(slow);
+        CHECK(same_state(native, slow));
+    }
+
+    // A store to data stays native. Turning the upcoming INC r1 into HLT has
+    // to stop the run there; the same store into dead code changes nothing.
+    // 0: LDI r2,200 | 3: LDI r3,255 | 6: ST [r2],r3 | 9: LDI r2,17 | 12: ST [r2],r3 | 15: INC r0 | 17: INC r1 | 19: HLT
+    std::vector<uint8_t> dna = { LDI, 2, 200, LDI, 3, 255, ST, 2, 3, LDI, 2, 17, ST, 2, 3, INC, 0, INC, 1, HLT };
+    for (uint8_t target : { 17, 40 }) {
+        dna[11] = target;
+        CellVM native, slow;
+        native.load_program(dna);
+        slow.load_program(dna);
+        CHECK(jit.compile(native));
+        jit.run(native);
+        step_to_end(slow);
+        CHECK(same_state(native, slow));
+        CHECK(native.registers[0] == 1 && native.registers[1] == (target == 17 ? 0 : 1));
+    }
+
+    // A cached translation is reused only for the memory it was made from
+    JitCache cache;
+    CellVM first, second;
+    first.load_program(dna);
+    JitProgram* program = cache.get(7, first);
+    CHECK(program && cache.get(7, first) == program && cache.hits == 1 && cache.compiles == 1);
+    dna[0] = NOP;
+    second.load_program(dna);
+    CHECK(cache.get(7, second) == program && cache.compiles == 2);
+    CHECK(program->matches(second) && !program->matches(first));
+}
+
+// restore() copies back only dirty pages; it has to match a VM that replays
+// the whole prefix. Between trials the restored VM is sometimes reset or
+// run natively, both of which dirty every page at once.
+static void test_vm_restore() {
+    JitProgram jit;
+    CellVM replayed, restored;
+    CellVM::Snapshot snap;
+    for (int g = 0; g < 20000; ++g) {
+        CounterRng rng(8, g, 0, 0);
+        std::vector<uint8_t> dna = random_bytes(rng, 128);
+        for (int k = 0; k < 10; ++k) dna[rng.below(128)] = ST; // Plenty of dirty pages
+        restored.reset();
+        restored.load_program(dna);
+        for (int i = 0; i < 50; ++i) restored.step();
+        restored.take_snapshot(snap);
+
+        for (int t = 0; t < 8; ++t) {
+            replayed.reset();
+            replayed.load_program(dna);
+            for (int i = 0; i < 50; ++i) replayed.step();
+            replayed.detect_cycles = restored.detect_cycles = g & 1;
+            if (t) restored.restore(snap);
+            CounterRng hit(g, 0, t, 0);
+            for (int k = 0; k < 2; ++k) {
+                uint32_t at = hit.below(128), value = hit.next();
+                replayed.poke(at, (uint8_t)value);
+                restored.poke(at, (uint8_t)value);
+            }
+            replayed.run();
+            bool native = t == 3 && JitProgram::supported() && jit.compile(restored);
+            if (native) jit.run(restored);
+            else restored.run();
+            CHECK(same_state(replayed, restored));
+            if (t == 5) restored.reset();
+        }
+    }
+
+    // Odd and large memories: fewer than 64 pages, or pages that don't divide it
+    for (size_t size : { 40, 100, 1000, 5000 }) {
+        GenesisVM a(nullptr, size), b(nullptr, size);
+        GenesisVM::Snapshot s;
+        CounterRng rng(9, size, 0, 0);
+        std::vector<uint8_t> dna = random_genome(rng, std::min<size_t>(size, 64));
+        b.load_program(dna);
+        b.take_snapshot(s);
+        for (int t = 0; t < 50; ++t) {
+            a.reset();
+            a.load_program(dna);
+            if (t % 3 == 0) b.reset();
+            b.restore(s);
+            size_t at = rng.below((uint32_t)size);
+            a.poke(at, (uint8_t)t);
+            b.poke(at, (uint8_t)t);
+            a.run();
+            b.run();
+            CHECK(same_state(a, b));
+        }
+    }
+}
+
+// Slices of organisms on the BatchVM score exactly like one at a time on the
+// interpreter, and a --batch run is the same run
+static void test_fitness_batch() {
+    for (const char* name : { "math", "consciousness" }) {
+        const FitnessMode& mode = fitness_mode(name);
+        WorkerState ws;
+        std::string target;
+        for (int round = 0; round < 2; ++round) {
+            std::vector<std::vector<uint8_t>> genomes;
+            if (round == 0) {
+                CounterRng rng(11, 0, 0, 0);
+                for (int i = 0; i < 301; ++i) genomes.push_back(random_genome(rng, 32));
+            } else {
+                DarwinEngine e(300, 32, 11); // Related genomes, as in a real run
+                e.set_mode(name);
+                e.set_quiet(true);
+                e.evolve(30);
+                for (const Organism& o : e.export_best(300)) genomes.push_back(o.dna);
+            }
+            std::vector<GenomeView> views(genomes.begin(), genomes.end());
+            std::vector<double> scores(views.size());
+            mode.score_batch(views.data(), views.size(), ws.batch, scores.data());
+            ScoreOptions native;
+            native.jit = true;
+            for (size_t i = 0; i < genomes.size(); ++i) {
+                ScoreContext ctx{ views[i], ws, target, 0, nullptr };
+                CHECK(scores[i] == mode.score(ctx));
+                // Compiled, then again from the worker's JitCache
+                CHECK(scores[i] == score_genome(mode, native, views[i], ws, target, 0));
+                CHECK(scores[i] == score_genome(mode, native, views[i], ws, target, 0));
+            }
+        }
+
+        Organism plain{ {}, 0 };
+        for (bool batch : { false, true }) {
+            DarwinEngine e(300, 32, 12);
+            e.set_mode(name);
+            e.set_quiet(true);
+            e.set_threads(batch ? 3 : 1);
+            e.set_batch_eval(batch);
+            e.evolve(30);
+            if (!batch) plain = e.get_best();
+            else CHECK(e.get_best().dna == plain.dna && e.get_best().fitness == plain.fitness);
+        }
+    }
+}
+
+// --- RNG ---
+
+static void test_rng_philox() {
+    // Known-answer vectors of Philox4x32-10 (Random123)
+    struct Kat { uint32_t counter[4], key[2], out[4]; };
+    const Kat kats[] = {
+        { { 0, 0, 0, 0 }, { 0, 0 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+        { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff },
+          { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+        { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 },
+          { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+    };
+    for (const Kat& k : kats) {
+        uint32_t out[4];
+        Philox4x32::block(k.counter, k.key, out);
+        CHECK(std::memcmp(out, k.out, sizeof(out)) == 0);
+    }
+
+    // Streams are pure functions of their tuple and differ between tuples
+    CounterRng a(9, 3, 17, 2), b(9, 3, 17, 2), c(9, 3, 18, 2);
+    bool differs = false;
+    for (int i = 0; i < 100; ++i) {
+        uint32_t x = a.next();
+        CHECK(x == b.next());
+        differs |= x != c.next();
+    }
+    CHECK(differs);
+}
+
+static void test_evolve_threads() {
+    for (const char* mode : { "string", "math", "survival", "consciousness" }) {
+        Organism first{ {}, 0 };
+        for (unsigned threads : { 1u, 3u }) {
+            DarwinEngine e(400, std::string(mode) == "survival" ? 64 : 32, 12345);
+            e.set_mode(mode);
+            e.set_target("Hi");
+            e.set_quiet(true);
+            e.set_threads(threads);
+            e.evolve(40);
+            Organism best = e.get_best();
+            if (threads == 1) first = best;
+            else CHECK(best.dna == first.dna && best.fitness == first.fitness);
+        }
+    }
+}
+
+// Islands draw everything from the 64-bit seed, so seeds differing only in
+// their high half give different runs, and one thread repeats a run exactly
+static void test_islands_seed() {
+    auto run = [](uint64_t seed) {
+        IslandModel model(4, 100, 32, seed);
+        model.set_mode("consciousness");
+        model.set_migration(5, 2, Topology::RANDOM);
+        model.evolve(20);
+        std::vector<size_t> arrivals;
+        for (size_t i = 0; i < model.island_count(); ++i) arrivals.push_back(model.get_stats(i).migrants_in);
+        return std::make_pair(model.get_best().dna, arrivals);
+    };
+    uint64_t seed = 0x1234567890ull;
+    CHECK(run(seed) == run(seed));
+    CHECK(run(seed).first != run(seed + (1ull << 32)).first);
+}
+
+// --- Checkpoints ---
+
+// "pruned" column of a --metrics CSV, one entry per generation
+static std::vector<long> pruned_counts(const char* path) {
+    std::vector<long> counts;
+    FILE* f = std::fopen(path, "r");
+    if (!f) return counts;
+    char line[1024];
+    while (std::fgets(line, sizeof(line), f)) {
+        unsigned long long generation;
+        double best, mean;
+        long evaluated, pruned;
+        if (std::sscanf(line, "%llu,%lf,%lf,%ld,%ld", &generation, &best, &mean, &evaluated, &pruned) == 5) {
+            counts.push_back(pruned);
+        }
+    }
+    std::fclose(f);
+    return counts;
+}
+
+static void test_checkpoint_resume() {
+    const char* path = "genesis_tests_checkpoint.tmp";
+    const char* logs[2] = { "genesis_tests_metrics_0.csv", "genesis_tests_metrics_1.csv" };
+    for (const char* mode : { "string", "math", "survival", "consciousness" }) {
+        for (bool prune : { false, true }) {
+            // Without a cache, pruning sees every organism, so its counts must repeat
+            auto engine = [&](size_t pop, int dna, uint64_t seed) {
+                std::unique_ptr<DarwinEngine> e(new DarwinEngine(pop, dna, seed));
+                e->set_mode(mode);
+                e->set_target("Hi");
+                e->set_quiet(true);
+                e->set_pruning(prune);
+                if (prune) e->set_cache_capacity(0);
+                return e;
+            };
+            auto straight = engine(300, 32, 7);
+            straight->evolve(8);
+            if (prune) straight->set_metrics(logs[0]);
+            straight->evolve(22);
+            std::vector<Organism> x = straight->export_best(300);
+            straight.reset(); // Closes the log
+
+            auto first = engine(300, 32, 7);
+            first->evolve(8);
+            CHECK(first->save_checkpoint(path));
+
+            auto resumed = engine(10, 8, 1); // Shape and seed come from the file
+            CHECK(resumed->load_checkpoint(path));
+            CHECK(resumed->get_generation() == 8);
+            if (prune) resumed->set_metrics(logs[1]);
+            resumed->evolve(22);
+            std::vector<Organism> y = resumed->export_best(300);
+            resumed.reset();
+            if (prune) CHECK(pruned_counts(logs[0]) == pruned_counts(logs[1]) && pruned_counts(logs[0]).size() == 22);
+
+            // The whole population, not just the best: bounds of pruned organisms included
+            bool same = x.size() == y.size();
+            for (size_t i = 0; same && i < x.size(); ++i) same = x[i].dna == y[i].dna && x[i].fitness == y[i].fitness;
+            CHECK(same);
+        }
+    }
+    std::remove(logs[0]);
+    std::remove(logs[1]);
+
+    // Wrong mode and truncated files are refused
+    DarwinEngine other(10, 8, 1);
+    other.set_mode("math");
+    other.set_quiet(true);
+    CHECK(!other.load_checkpoint(path));
+    FILE* f = std::fopen(path, "rb");
+    std::vector<char> bytes;
+    if (f) {
+        int c;
+        while ((c = std::fgetc(f)) != EOF) bytes.push_back((char)c);
+        std::fclose(f);
+    }
+    f = std::fopen(path, "wb");
+    if (f) {
+        std::fwrite(bytes.data(), 1, bytes.size() - 1, f);
+        std::fclose(f);
+    }
+    DarwinEngine cut(10, 8, 1);
+    cut.set_mode("consciousness");
+    cut.set_quiet(true);
+    CHECK(!cut.load_checkpoint(path));
+
+    // So are headers whose sizes wrap around to the real payload length
+    // or point past the end of the file
+    DarwinEngine same(10, 8, 1);
+    same.set_mode("consciousness");
+    same.set_target("Hi");
+    same.set_quiet(true);
+    for (int corrupt = 0; corrupt < 3; ++corrupt) {
+        CheckpointHeader h;
+        std::memcpy(&h, bytes.data(), sizeof(h));
+        if (corrupt == 1) h.population += 1ull << 61; // x (8 + 32) bytes wraps to the same size
+        if (corrupt == 2) h.target_bytes = 0xFFFFFFF0u;
+        f = std::fopen(path, "wb");
+        if (f) {
+            std::fwrite(&h, 1, sizeof(h), f);
+            std::fwrite(bytes.data() + sizeof(h), 1, bytes.size() - sizeof(h), f);
+            std::fclose(f);
+        }
+        CHECK(same.load_checkpoint(path) == (corrupt == 0));
+    }
+    std::remove(path);
+}
+
+// Every generation starts both engines from the same checkpoint, so only
+// pruning differs: the elites it picks must match the full scores
+static void test_checkpoint_prune() {
+    const char* path = "genesis_tests_prune.tmp";
+    const char* log = "genesis_tests_prune.csv";
+    for (const char* mode : { "math", "consciousness" }) {
+        auto engine = [&](bool prune) {
+            std::unique_ptr<DarwinEngine> e(new DarwinEngine(300, 32, 11));
+            e->set_mode(mode);
+            e->set_quiet(true);
+            e->set_pruning(prune);
+            return e;
+        };
+        auto full = engine(false);
+        auto pruned = engine(true);
+        CHECK(pruned->set_metrics(log));
+        bool same = true;
+        for (int g = 0; g < 20; ++g) {
+            CHECK(full->save_checkpoint(path));
+            CHECK(pruned->load_checkpoint(path));
+            full->evolve(1);
+            pruned->evolve(1);
+            std::vector<Organism> x = full->export_best(60);
+            std::vector<Organism> y = pruned->export_best(60);
+            for (size_t i = 0; i < x.size(); ++i) same = same && x[i].dna == y[i].dna && x[i].fitness == y[i].fitness;
+        }
+        CHECK(same);
+        pruned.reset(); // Closes the log
+        long total = 0;
+        for (long n : pruned_counts(log)) total += n;
+        CHECK(total > 0);
+    }
+    std::remove(path);
+    std::remove(log);
+}
+
+// --- Allocation-free scoring ---
+
+static void test_alloc_scoring() {
+    WorkerState ws;
+    std::string target = "Hi";
+    CounterRng rng(5, 0, 0, 0);
+    std::vector<std::vector<uint8_t>> genomes;
+    for (int i = 0; i < 64; ++i) genomes.push_back(random_genome(rng, i % 2 ? 128 : 32));
+
+    for (const char* name : { "string", "math", "survival", "consciousness" }) {
+        const FitnessMode& mode = fitness_mode(name);
+        for (int route = 0; route < 3; ++route) { // Interpreter, JIT, BatchVM
+            if (route == 1 && (!mode.deterministic || !JitProgram::supported())) continue;
+            if (route == 2 && !mode.score_batch) continue;
+            ScoreOptions options;
+            options.jit = route == 1;
+            options.batch = route == 2;
+            auto score = [&](const std::vector<uint8_t>& dna) {
+                return score_genome(mode, options, dna, ws, target, 42);
+            };
+            for (auto& g : genomes) score(g); // Warm up: buffers reach their final size
+            long before = allocations;
+            double sum = 0;
+            for (int pass = 0; pass < 4; ++pass) {
+                for (auto& g : genomes) sum += score(g);
+            }
+            long made = allocations - before;
+            if (made) std::printf("  %s route %d: %ld allocations\n", name, route, made);
+            CHECK(made == 0);
+            CHECK(sum == sum); // Keep the scores alive
+        }
+    }
+}
+
+// --- Arena recording and ownership ---
+
+template <typename Word>
+static void check_replay(const std::vector<std::vector<uint8_t>>& programs, int cycles) {
+    const char* path = "genesis_tests_battle.tmp";
+    typedef BasicArena<Word> A;
+    A arena(A::DEFAULT_CORE);
+    BattleRecorder recorder(100);
+    CHECK(recorder.open(path));
+    arena.set_recorder(&recorder);
+    arena.load_warriors(programs);
+    BattleResult full = arena.simulate(cycles);
+    arena.set_recorder(nullptr);
+
+    BattlePlayer player;
+    CHECK(player.open(path));
+    CHECK(player.rounds() == full.cycles && player.winner() == full.winner);
+    // Forwards, then backwards through the keyframes
+    std::vector<int> rounds;
+    for (int r = 0; r <= full.cycles; r += 37) rounds.push_back(r);
+    for (int r = full.cycles; r >= 0; r -= 91) rounds.push_back(r);
+    for (int r : rounds) {
+        A ref(A::DEFAULT_CORE);
+        ref.load_warriors(programs);
+        ref.simulate(r);
+        CHECK(player.seek(r));
+        CHECK(player.memory() == ref.memory);
+        CHECK(player.ownership() == ref.ownership());
+        for (size_t k = 0; k < programs.size(); ++k) {
+            CHECK(player.ips()[k] == (size_t)ref.warriors[k]->ip);
+            CHECK(player.territory(k) == ref.territory(k));
+        }
+    }
+    std::remove(path);
+}
+
+static std::vector<std::vector<uint8_t>> random_warriors(int seed, int word_bytes) {
+    CounterRng rng(6, seed, word_bytes, 0);
+    if (seed < 3) {
+        const char* kinds[] = { "bomber", "replicator", "runner" };
+        return { builtin_warrior(kinds[seed], word_bytes), builtin_warrior(kinds[(seed + 1) % 3], word_bytes),
+                 builtin_warrior("bomber", word_bytes) };
+    }
+    std::vector<std::vector<uint8_t>> programs;
+    for (int i = 0; i < 2 + seed % 3; ++i) {
+        std::vector<uint8_t> code(40);
+        for (auto& x : code) x = rng.below(3) == 0 ? (uint8_t)ST : (uint8_t)rng.below(12);
+        programs.push_back(code);
+    }
+    return programs;
+}
+
+static void test_arena_replay() {
+    for (int t = 0; t < 8; ++t) {
+        check_replay<uint8_t>(random_warriors(t, 1), 1500);
+        check_replay<uint16_t>(random_warriors(t, 2), 1500);
+        check_replay<uint32_t>(random_warriors(t, 4), 1500);
+    }
+}
+
+struct OwnerRef { std::vector<uint8_t>* owner; uint8_t id; };
+static void track_store(void* context, size_t addr, uint8_t) {
+    OwnerRef* r = (OwnerRef*)context;
+    (*r->owner)[addr] = r->id;
+}
+
+static void test_arena_ownership() {
+    for (int t = 0; t < 100; ++t) {
+        std::vector<std::vector<uint8_t>> programs = random_warriors(t, 2);
+        CounterRng rng(7, t, 0, 0);
+        Arena arena(256 + rng.below(4000));
+        arena.load_warriors(programs);
+        // Independent map, kept by the store hook
+        std::vector<uint8_t> ref = arena.ownership();
+        std::vector<OwnerRef> refs(programs.size());
+        for (size_t k = 0; k < programs.size(); ++k) {
+            refs[k] = { &ref, (uint8_t)(k + 1) };
+            arena.warriors[k]->store_hook = track_store;
+            arena.warriors[k]->store_hook_context = &refs[k];
+        }
+        BattleResult r = arena.simulate(2000);
+        CHECK(ref == arena.ownership());
+        for (size_t k = 0; k < programs.size(); ++k) {
+            long count = 0;
+            for (uint8_t o : ref) count += o == k + 1;
+            CHECK((long)arena.territory(k) == count && r.territory[k] == count);
+        }
+    }
+
+    // A decisive share ends the battle with its holder ahead
+    Arena arena(1024);
+    arena.set_cycle_budget(100000);
+    arena.set_decisive_share(0.6);
+    arena.load_warriors(builtin_warrior("bomber", 2), builtin_warrior("runner", 2));
+    BattleResult r = arena.simulate(100000);
+    CHECK(r.decided == 1 && r.winner == 1 && r.cycles < 100000);
+    CHECK(r.territory[0] >= 615);
+}
+
+// --- Serve mode ---
+
+static std::vector<std::string> serve_lines(JobServer& server, const std::string& jobs) {
+    FILE* in = std::tmpfile();
+    FILE* out = std::tmpfile();
+    std::vector<std::string> replies;
+    if (!in || !out) return replies;
+    std::fputs(jobs.c_str(), in);
+    std::rewind(in);
+    CHECK(server.serve(in, out));
+    std::rewind(out);
+    char line[4096];
+    while (std::fgets(line, sizeof(line), out)) replies.push_back(std::string(line, std::strcspn(line, "\n")));
+    std::fclose(in);
+    std::fclose(out);
+    return replies;
+}
+
+static void test_server_jobs() {
+    CounterRng rng(10, 0, 0, 0);
+    std::vector<uint8_t> fits = random_genome(rng, 64), too_long = random_genome(rng, 300);
+    JobServer server(2);
+    server.set_jit(true);
+    // One more warrior than an arena can tell apart
+    std::string crowd = "battle";
+    for (size_t i = 0; i <= Arena::MAX_WARRIORS; ++i) crowd += " runner";
+    std::vector<std::string> replies = serve_lines(server,
+        "score math " + BioCompiler::encode(fits) + "\n"
+        "score consciousness " + BioCompiler::encode(too_long) + "\n"
+        "\n"
+        "decode ATGCGTATAA\n"
+        "score nonsense ACGT\n"
+        "launch\n"
+        "battle bomber " + BioCompiler::tag_width(BioCompiler::encode(builtin_warrior("runner", 1)), 1) + "\n" +
+        crowd + "\n");
+    CHECK(replies.size() == 7);
+    if (replies.size() != 7) return;
+
+    // The same score DarwinEngine would give it
+    WorkerState ws;
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "ok %.17g", score_genome(fitness_mode("math"), ScoreOptions(), fits, ws, "", 0));
+    CHECK(replies[0] == expected);
+    CHECK(replies[1] == "err DNA too long");
+    CHECK(replies[2] == "ok 6C");
+    CHECK(replies[3].compare(0, 4, "err ") == 0 && replies[4].compare(0, 4, "err ") == 0);
+    CHECK(replies[5] == "err warrior 2 is 8-bit DNA");
+    CHECK(replies[6] == "err at most 255 warriors");
+    CHECK(server.jobs_done() == 7);
+}
+
+// --- Driver ---
+
+struct Test { const char* name; void (*run)(); };
+
+static const Test tests[] = {
+    { "bio.decode", test_bio_decode },
+    { "bio.round-trip", test_bio_round_trip },
+    { "vm.decoded", test_vm_decoded },
+    { "vm.jit", test_vm_jit },
+    { "vm.restore", test_vm_restore },
+    { "fitness.batch", test_fitness_batch },
+    { "rng.philox", test_rng_philox },
+    { "evolve.threads", test_evolve_threads },
+    { "islands.seed", test_islands_seed },
+    { "checkpoint.resume", test_checkpoint_resume },
+    { "checkpoint.prune", test_checkpoint_prune },
+    { "alloc.scoring", test_alloc_scoring },
+    { "arena.replay", test_arena_replay },
+    { "arena.ownership", test_arena_ownership },
+    { "server.jobs", test_server_jobs },
+};
+
+int main(int argc, char* argv[]) {
+    int failed = 0, ran = 0;
+    for (const Test& t : tests) {
+        bool wanted = argc < 2;
+        for (int i = 1; i < argc; ++i) wanted |= std::strstr(t.name, argv[i]) != nullptr;
+        if (!wanted) continue;
+        int before = failures;
+        t.run();
+        ran++;
+        bool ok = failures == before;
+        if (!ok) failed++;
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", t.name);
+    }
+    std::printf("%d of %d passed\n", ran - failed, ran);
+    return failed ? 1 : 0;
+}
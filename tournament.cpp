@@ -0,0 +1,154 @@
+#include "tournament.h"
+#include "replay.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <iostream>
+#include <cstdio>
+
+static const double ELO_K = 32.0;
+
+Tournament::Tournament() {
+    set_threads(1);
+}
+
+void Tournament::add_warrior(const std::string& name, const std::vector<uint8_t>& code) {
+    Warrior w;
+    w.name = name;
+    w.code = code;
+    warriors.push_back(w);
+}
+
+void Tournament::set_threads(unsigned n) {
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+    pool.reset(new WorkerPool(n));
+    arenas.clear();
+    for (unsigned i = 0; i < n; ++i) {
+        arenas.emplace_back(new Arena(core_size));
+        arenas.back()->set_cycle_budget(cycle_budget);
+        arenas.back()->set_decisive_share(decisive_share);
+    }
+}
+
+void Tournament::set_core_size(size_t n) {
+    core_size = n;
+    set_threads(pool->size());
+}
+
+void Tournament::set_decisive_share(double share) {
+    decisive_share = share;
+    for (auto& a : arenas) a->set_decisive_share(share);
+}
+
+void Tournament::set_record_dir(const std::string& dir) {
+    record_dir = dir;
+}
+
+void Tournament::set_cycles(int n) {
+    cycles = n;
+}
+
+void Tournament::set_cycle_budget(int n) {
+    cycle_budget = n;
+    for (auto& a : arenas) a->set_cycle_budget(n);
+}
+
+void Tournament::record(const Game& g, const BattleResult& r) {
+    Warrior& a = warriors[g.a];
+    Warrior& b = warriors[g.b];
+    
+    double score_a = r.winner == 1 ? 1.0 : r.winner == 2 ? 0.0 : 0.5;
+    if (r.winner == 1) { a.wins++; b.losses++; }
+    else if (r.winner == 2) { b.wins++; a.losses++; }
+    else { a.draws++; b.draws++; }
+    a.points += score_a;
+    b.points += 1.0 - score_a;
+    
+    double expected_a = 1.0 / (1.0 + std::pow(10.0, (b.rating - a.rating) / 400.0));
+    double delta = ELO_K * (score_a - expected_a);
+    a.rating += delta;
+    b.rating -= delta;
+}
+
+void Tournament::play(const std::vector<Game>& games) {
+    std::vector<BattleResult> results(games.size());
+    pool->parallel_for(games.size(), [&](size_t k, unsigned worker) {
+        Arena& arena = *arenas[worker];
+        BattleRecorder recorder;
+        if (!record_dir.empty()) {
+            char name[32];
+            snprintf(name, sizeof(name), "/battle_%06zu.gbr", battle_count + k);
+            if (recorder.open(record_dir + name)) arena.set_recorder(&recorder);
+            else std::cerr << "Replay: cannot write " << record_dir + name << std::endl;
+        }
+        arena.load_warriors(warriors[games[k].a].code, warriors[games[k].b].code);
+        results[k] = arena.simulate(cycles);
+        arena.set_recorder(nullptr);
+    });
+    
+    for (size_t k = 0; k < games.size(); ++k) record(games[k], results[k]);
+    if (!record_dir.empty()) {
+        // Which log is which: number, P1, P2, winner (0 = draw)
+        FILE* list = std::fopen((record_dir + "/battles.txt").c_str(), battle_count ? "a" : "w");
+        for (size_t k = 0; list && k < games.size(); ++k) {
+            fprintf(list, "battle_%06zu.gbr %s %s %d\n", battle_count + k, warriors[games[k].a].name.c_str(),
+                    warriors[games[k].b].name.c_str(), results[k].winner);
+        }
+        if (list) std::fclose(list);
+    }
+    battle_count += games.size();
+}
+
+void Tournament::run_round_robin() {
+    std::vector<Game> games;
+    for (size_t a = 0; a < warriors.size(); ++a) {
+        for (size_t b = 0; b < warriors.size(); ++b) {
+            if (a != b) games.push_back({ a, b });
+        }
+    }
+    play(games);
+}
+
+// Each round pairs warriors with similar points (then rating) that have not
+// met yet. With an odd field the lowest unpaired warrior sits out.
+void Tournament::run_swiss(int rounds) {
+    std::set<std::pair<size_t, size_t>> met;
+    
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<size_t> order(warriors.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+            if (warriors[x].points != warriors[y].points) return warriors[x].points > warriors[y].points;
+            return warriors[x].rating > warriors[y].rating;
+        });
+        
+        std::vector<Game> games;
+        std::vector<bool> paired(order.size(), false);
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (paired[i]) continue;
+            // Nearest unpaired opponent not met yet, else the nearest at all
+            size_t pick = order.size();
+            for (size_t j = i + 1; j < order.size(); ++j) {
+                if (paired[j]) continue;
+                if (pick == order.size()) pick = j;
+                if (!met.count(std::minmax(order[i], order[j]))) { pick = j; break; }
+            }
+            if (pick == order.size()) break; // Bye
+            
+            paired[i] = paired[pick] = true;
+            size_t a = order[i], b = order[pick];
+            met.insert(std::minmax(a, b));
+            games.push_back({ a, b });
+            games.push_back({ b, a });
+        }
+        play(games);
+    }
+}
+
+std::vector<Warrior> Tournament::standings() const {
+    std::vector<Warrior> sorted = warriors;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Warrior& x, const Warrior& y) {
+        return x.rating > y.rating;
+    });
+    return sorted;
+}
@@ -0,0 +1,62 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "arena.h"
+#include "pool.h"
+
+struct Warrior {
+    std::string name;
+    std::vector<uint8_t> code;
+    double rating = 1500.0; // Elo
+    int wins = 0, losses = 0, draws = 0;
+    double points = 0.0;    // Win 1, draw 0.5 (Swiss pairing)
+};
+
+// Plays many headless battles at once, one Arena per worker thread, and
+// rates the warriors with Elo. Every pairing is fought twice with the
+// seats swapped, since P1 starts at address 0 and moves first. Warriors
+// are 16-bit code (Arena's address width).
+class Tournament {
+public:
+    Tournament();
+
+    void add_warrior(const std::string& name, const std::vector<uint8_t>& code);
+    void set_threads(unsigned n);  // 0 = all cores
+    void set_cycles(int n);        // Rounds per battle (default 5000)
+    void set_cycle_budget(int n);  // Instructions per warrior (default 1000)
+    void set_core_size(size_t n);  // Arena bytes (default 1024, at most 64 KB)
+    void set_decisive_share(double share); // End battles early (Arena::set_decisive_share)
+    void set_record_dir(const std::string& dir); // Log every battle to dir/battle_NNNNNN.gbr (replay.h)
+
+    void run_round_robin();
+    void run_swiss(int rounds);
+
+    // Warriors sorted by rating, best first
+    std::vector<Warrior> standings() const;
+    size_t warrior_count() const { return warriors.size(); }
+    size_t battles_played() const { return battle_count; }
+
+private:
+    struct Game { size_t a, b; }; // a sits in P1
+    
+    std::vector<Warrior> warriors;
+    std::unique_ptr<WorkerPool> pool;
+    std::vector<std::unique_ptr<Arena>> arenas; // One per worker
+    int cycles = 5000;
+    int cycle_budget = 1000;
+    size_t core_size = Arena::DEFAULT_CORE;
+    double decisive_share = 0;
+    size_t battle_count = 0;
+    std::string record_dir;
+
+    // Fights all games in parallel, then applies the results in game
+    // order so ratings do not depend on the thread count.
+    void play(const std::vector<Game>& games);
+    void record(const Game& g, const BattleResult& r);
+};
+
+#endif
@@ -1,27 +1,53 @@
 #include "vm.h"
+#include "metrics.h"
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 
-GenesisVM::GenesisVM(uint8_t* shared_mem, size_t size) : mem_size(size) {
+bool OutputBuffer::contains(const std::string& s) const {
+    if (s.empty()) return true;
+    size_t n = stored();
+    if (s.size() > n) return false;
+    for (size_t i = 0; i + s.size() <= n; ++i) {
+        if (bytes[i] == (uint8_t)s[0] && std::memcmp(bytes + i, s.data(), s.size()) == 0) return true;
+    }
+    return false;
+}
+
+// Every member below is a template; the instantiations we ship are listed
+// at the bottom of this file.
+#define VM_TEMPLATE template <size_t MemSize, size_t NumRegs, typename Word>
+#define VM BasicVM<MemSize, NumRegs, Word>
+
+VM_TEMPLATE
+VM::BasicVM(uint8_t* shared_mem, size_t size) : mem_size(MemSize ? MemSize : size) {
+    mem_mask = (mem_size > 1 && (mem_size & (mem_size - 1)) == 0) ? mem_size - 1 : 0;
+    page_shift = 4;
+    while (((mem_size - 1) >> page_shift) >= 64) page_shift++;
+    size_t pages = ((mem_size - 1) >> page_shift) + 1;
+    page_mask = pages >= 64 ? ~0ull : (1ull << pages) - 1;
     if (shared_mem) {
         memory = shared_mem;
         owns_memory = false;
     } else {
-        memory = new uint8_t[size];
+        memory = new uint8_t[mem_size];
         owns_memory = true;
     }
     reset();
 }
 
-GenesisVM::~GenesisVM() {
+VM_TEMPLATE
+VM::~BasicVM() {
     if (owns_memory) {
         delete[] memory;
     }
 }
 
-void GenesisVM::reset() {
+VM_TEMPLATE
+void VM::reset() {
     if (owns_memory) {
         std::memset(memory, 0, mem_size);
+        mark_all_dirty();
     }
     // If shared memory, we ideally don't wipe it on reset? 
     // But for Darwin loop we do. For Arena we might not?
@@ -33,102 +59,179 @@ void GenesisVM::reset() {
     ip = 0;
     halted = false;
     instructions_executed = 0;
+    cycles_skipped = 0;
 }
 
-std::string GenesisVM::get_output_string() {
-    return std::string(output_buffer.begin(), output_buffer.end());
+VM_TEMPLATE
+std::string VM::get_output_string() {
+    return std::string((const char*)output_buffer.data(), output_buffer.stored());
 }
 
-void GenesisVM::load_program(const std::vector<uint8_t>& program) {
+VM_TEMPLATE
+void VM::load_program(GenomeView program) {
     if (program.size() > mem_size) {
         std::cerr << "Error: DNA too long for cell memory." << std::endl;
         return;
     }
     std::memcpy(memory, program.data(), program.size());
+    for (size_t a = 0; a < program.size(); a += (size_t)1 << page_shift) mark_dirty(a);
+    if (program.size()) mark_dirty(program.size() - 1);
+}
+
+VM_TEMPLATE
+void VM::take_snapshot(Snapshot& s) {
+    std::memcpy(s.registers, registers, sizeof(registers));
+    s.ip = ip;
+    s.halted = halted;
+    s.instructions_executed = instructions_executed;
+    s.cycles_skipped = cycles_skipped;
+    s.memory.assign(memory, memory + mem_size);
+    s.output.assign(output_buffer.data(), output_buffer.data() + output_buffer.stored());
+    s.output_length = output_buffer.size();
+    dirty_pages = 0;
+    base_snapshot = &s;
+}
+
+VM_TEMPLATE
+void VM::restore(const Snapshot& s) {
+    std::memcpy(registers, s.registers, sizeof(registers));
+    ip = s.ip;
+    halted = s.halted;
+    instructions_executed = s.instructions_executed;
+    cycles_skipped = s.cycles_skipped;
+    if (!s.output.empty()) std::memcpy(output_buffer.bytes, s.output.data(), s.output.size());
+    output_buffer.length = s.output_length;
+
+    if (&s != base_snapshot || !owns_memory || s.memory.size() != mem_size) {
+        std::memcpy(memory, s.memory.data(), std::min(s.memory.size(), mem_size));
+    } else {
+        size_t page = (size_t)1 << page_shift;
+        size_t from = 0;
+        for (uint64_t d = dirty_pages; d && from < mem_size; d >>= 1, from += page) {
+            if (d & 1) std::memcpy(memory + from, s.memory.data() + from, std::min(page, mem_size - from));
+        }
+    }
+    dirty_pages = 0;
+    base_snapshot = &s;
 }
 
-uint8_t GenesisVM::fetch() {
-    return memory[ip++ % mem_size]; // Safe wrap
+VM_TEMPLATE
+uint8_t VM::fetch() {
+    if constexpr (sizeof(Word) == 1) {
+        return memory[wrap(ip++)]; // Safe wrap
+    } else {
+        // A wide ip is kept inside memory, so it never overflows its Word
+        // and jumps back to 0 in the middle of a core
+        uint8_t byte = memory[wrap(ip)];
+        ip = (Word)wrap((size_t)ip + 1);
+        return byte;
+    }
 }
 
-void GenesisVM::step() {
+// Immediates are sizeof(Word) bytes, little-endian
+VM_TEMPLATE
+Word VM::fetch_word() {
+    Word value = 0;
+    for (size_t i = 0; i < sizeof(Word); ++i) {
+        value |= (Word)((Word)fetch() << (8 * i));
+    }
+    return value;
+}
+
+VM_TEMPLATE
+void VM::step() {
     if (halted) return;
     
     if (instructions_executed >= MAX_CYCLES) {
         halted = true; 
+        metrics::count_budget_hit();
         return;
     }
 
     uint8_t opcode = fetch();
+    metrics::count_op(opcode);
     execute(opcode);
     instructions_executed++;
+    if (halted) metrics::count_halt(instructions_executed);
 }
 
-void GenesisVM::run() {
+VM_TEMPLATE
+void VM::run() {
+    // Shared memory (Arena) can be rewritten by another VM between our
+    // instructions, so only a cell that owns its memory may run pre-decoded.
+    if constexpr (sizeof(Word) == 1) {
+        if (owns_memory) {
+            if (halted) return;
+            if (detect_cycles) run_decoded<true>();
+            else run_decoded<false>();
+            return;
+        }
+    }
     while (!halted) {
         step();
     }
 }
 
-void GenesisVM::execute(uint8_t opcode) {
+VM_TEMPLATE
+void VM::execute(uint8_t opcode) {
     // Helper macros for extracting operands safely
-    #define ARG_REG(x) (memory[(ip + x) % mem_size] % 4) // Safe Modulo 4 for valid reg
-    #define ARG_IMM(x) (memory[(ip + x) % mem_size])     // Safe memory access
+    #define ARG_REG(x) reg(memory[wrap(ip + x)])    // Safe modulo for valid reg
+    #define ARG_IMM(x) (memory[wrap(ip + x)])       // Safe memory access
 
     switch (opcode) {
         case NOP:
             break;
 
         case INC: {
-            uint8_t reg = fetch() % 4; 
-            registers[reg]++;
+            uint8_t r = reg(fetch()); 
+            registers[r]++;
             break;
         }
 
         case DEC: {
-            uint8_t reg = fetch() % 4;
-            registers[reg]--;
+            uint8_t r = reg(fetch());
+            registers[r]--;
             break;
         }
 
         case ADD: {
-            uint8_t dst = fetch() % 4;
-            uint8_t src = fetch() % 4;
+            uint8_t dst = reg(fetch());
+            uint8_t src = reg(fetch());
             registers[dst] += registers[src];
             break;
         }
 
         case SUB: {
-            uint8_t dst = fetch() % 4;
-            uint8_t src = fetch() % 4;
+            uint8_t dst = reg(fetch());
+            uint8_t src = reg(fetch());
             registers[dst] -= registers[src];
             break;
         }
 
         case MOV: {
-            uint8_t dst = fetch() % 4;
-            uint8_t src = fetch() % 4;
+            uint8_t dst = reg(fetch());
+            uint8_t src = reg(fetch());
             registers[dst] = registers[src];
             break;
         }
 
         case LDI: {
-            uint8_t dst = fetch() % 4;
-            uint8_t val = fetch();
+            uint8_t dst = reg(fetch());
+            Word val = fetch_word();
             registers[dst] = val;
             break;
         }
 
         case JMP: {
-            uint8_t target = fetch();
-            ip = target % mem_size;
+            Word target = fetch_word();
+            ip = (Word)wrap(target);
             break;
         }
 
         case JZ: {
-            uint8_t target = fetch();
+            Word target = fetch_word();
             if (registers[0] == 0) {
-                ip = target % mem_size;
+                ip = (Word)wrap(target);
             }
             break;
         }
@@ -136,29 +239,37 @@ void GenesisVM::execute(uint8_t opcode) {
         case IO: {
             uint8_t port = fetch();
             if (port == 0) {
-                output_buffer.push_back(registers[0]);
+                output_buffer.push_back((uint8_t)registers[0]);
             } else if (port == 1) {
-                 std::string s = std::to_string(registers[0]);
-                 for (char c : s) output_buffer.push_back(c);
+                 output_buffer.append_number(registers[0]);
             }
             break;
         }
         
         case LD: {
             // LD R<dst>, R<addr_reg>
-            uint8_t dst = fetch() % 4;
-            uint8_t addr_reg = fetch() % 4;
-            uint8_t addr = registers[addr_reg];
-            registers[dst] = memory[addr % mem_size];
+            uint8_t dst = reg(fetch());
+            uint8_t addr_reg = reg(fetch());
+            Word addr = registers[addr_reg];
+            registers[dst] = memory[wrap(addr)];
             break;
         }
         
         case ST: {
             // ST R<addr_reg>, R<src>
-            uint8_t addr_reg = fetch() % 4;
-            uint8_t src = fetch() % 4;
-            uint8_t addr = registers[addr_reg];
-            memory[addr % mem_size] = registers[src];
+            uint8_t addr_reg = reg(fetch());
+            uint8_t src = reg(fetch());
+            size_t at = wrap(registers[addr_reg]);
+            uint8_t value = (uint8_t)registers[src];
+            memory[at] = value;
+            mark_dirty(at);
+            if (owner_map) {
+                uint8_t& owner = owner_map[at];
+                owner_counts[owner]--;
+                owner_counts[owner_id]++;
+                owner = owner_id;
+            }
+            if (store_hook) store_hook(store_hook_context, at, value);
             break;
         }
 
@@ -170,3 +281,201 @@ void GenesisVM::execute(uint8_t opcode) {
             break;
     }
 }
+
+// --- Pre-decoded fast path ---
+// run_decoded() behaves exactly like calling step() until halted, but decodes
+// each instruction once into `decoded[ip]` and dispatches through a label
+// table (computed goto on GCC/Clang, a switch elsewhere). Entries are decoded
+// lazily and dropped again when ST writes into their bytes.
+//
+// With DetectCycles, the state (registers, ip, memory, output length) is
+// compared against a checkpoint that is re-taken at doubling intervals
+// (Brent's method). Memory is tracked by a counter of byte-changing stores,
+// so it is never hashed. A repeat means the VM is in a cycle of known
+// period: whole periods are skipped and only the remainder is executed,
+// giving exactly the state a full MAX_CYCLES run would end in. Output never
+// feeds back into execution, so a looping printer is skipped too: each
+// skipped period appends the same bytes the last one printed.
+
+#if defined(__GNUC__) && !defined(GENESIS_NO_COMPUTED_GOTO)
+#define GENESIS_COMPUTED_GOTO 1
+#endif
+
+enum Handler : uint8_t {
+    H_DECODE = 0, H_NOP, H_INC, H_DEC, H_ADD, H_SUB, H_MOV, H_LDI,
+    H_JMP, H_JZ, H_PUTC, H_PUTI, H_LD, H_ST, H_HLT
+};
+
+VM_TEMPLATE
+void VM::decode_at(uint8_t pc) {
+    auto at = [&](int k) { return memory[wrap((uint8_t)(pc + k))]; };
+    DecodedInsn& d = decoded[pc];
+    d.a = d.b = d.target = 0;
+
+    switch (at(0)) {
+        case INC: d.handler = H_INC; d.a = reg(at(1)); d.next = pc + 2; break;
+        case DEC: d.handler = H_DEC; d.a = reg(at(1)); d.next = pc + 2; break;
+        case ADD: d.handler = H_ADD; d.a = reg(at(1)); d.b = reg(at(2)); d.next = pc + 3; break;
+        case SUB: d.handler = H_SUB; d.a = reg(at(1)); d.b = reg(at(2)); d.next = pc + 3; break;
+        case MOV: d.handler = H_MOV; d.a = reg(at(1)); d.b = reg(at(2)); d.next = pc + 3; break;
+        case LDI: d.handler = H_LDI; d.a = reg(at(1)); d.b = at(2);     d.next = pc + 3; break;
+        case JMP: d.handler = H_JMP; d.next = (uint8_t)wrap(at(1)); break;
+        case JZ:  d.handler = H_JZ;  d.target = (uint8_t)wrap(at(1)); d.next = pc + 2; break;
+        case IO: {
+            uint8_t port = at(1);
+            d.handler = (port == 0) ? H_PUTC : (port == 1) ? H_PUTI : H_NOP;
+            d.next = pc + 2;
+            break;
+        }
+        case LD:  d.handler = H_LD;  d.a = reg(at(1)); d.b = reg(at(2)); d.next = pc + 3; break;
+        case ST:  d.handler = H_ST;  d.a = reg(at(1)); d.b = reg(at(2)); d.next = pc + 3; break;
+        case HLT: d.handler = H_HLT; d.next = pc + 1; break;
+        default:  d.handler = H_NOP; d.next = pc + 1; break;
+    }
+}
+
+VM_TEMPLATE
+void VM::invalidate_code(size_t addr) {
+    if (mem_size >= 256) {
+        // Only the first 256 bytes are reachable by ip; an instruction is at most 3 long
+        if (addr < 256) {
+            for (int k = 0; k < 3; ++k) decoded[(uint8_t)(addr - k)].handler = H_DECODE;
+        }
+    } else {
+        // Small cells alias several ip values onto one byte
+        std::memset(decoded, 0, sizeof(decoded));
+    }
+}
+
+// Appends output_buffer[from, end) `times` more times
+VM_TEMPLATE
+void VM::repeat_output(size_t from, int times) {
+    if (times <= 0) return;
+    output_buffer.repeat(from, (size_t)times);
+}
+
+VM_TEMPLATE
+template <bool DetectCycles>
+void VM::run_decoded() {
+    // Memory may have been poked from outside since the last run
+    std::memset(decoded, 0, sizeof(decoded));
+
+    Word r[NumRegs];
+    std::memcpy(r, registers, sizeof(r));
+    uint8_t pc = ip;
+    int executed = instructions_executed;
+    const DecodedInsn* d;
+
+    // Cycle detector state (unused unless DetectCycles)
+    bool watching = DetectCycles;
+    uint32_t writes = 0;
+    Word cp_regs[NumRegs];
+    uint32_t cp_writes = 0;
+    uint8_t cp_pc = pc;
+    size_t cp_out = output_buffer.size();
+    int cp_at = executed;
+    int power = 1;
+    std::memcpy(cp_regs, r, sizeof(r));
+
+#if GENESIS_METRICS
+    uint64_t* op_counts = metrics::local().opcodes;
+    #define TICK() (executed++, op_counts[memory[wrap(pc)]]++)
+#else
+    #define TICK() executed++
+#endif
+
+    #define CHECK_CYCLE() \
+        if (DetectCycles && watching && executed != cp_at) { \
+            if (pc == cp_pc && writes == cp_writes && std::memcmp(r, cp_regs, sizeof(r)) == 0) { \
+                int period = executed - cp_at; \
+                int left = MAX_CYCLES - executed; \
+                repeat_output(cp_out, left / period); \
+                cycles_skipped += left - left % period; \
+                executed += left - left % period; \
+                watching = false; \
+            } else if (executed - cp_at == power) { \
+                std::memcpy(cp_regs, r, sizeof(r)); cp_pc = pc; cp_writes = writes; \
+                cp_out = output_buffer.size(); cp_at = executed; \
+                power *= 2; \
+            } \
+        }
+
+#if GENESIS_COMPUTED_GOTO
+    static void* const labels[] = {
+        &&L_DECODE, &&L_NOP, &&L_INC, &&L_DEC, &&L_ADD, &&L_SUB, &&L_MOV, &&L_LDI,
+        &&L_JMP, &&L_JZ, &&L_PUTC, &&L_PUTI, &&L_LD, &&L_ST, &&L_HLT
+    };
+    #define OP(name) L_##name:
+    #define NEXT() do { CHECK_CYCLE() \
+                        if (executed >= MAX_CYCLES) goto out_of_cycles; \
+                        d = &decoded[pc]; goto *labels[d->handler]; } while (0)
+    NEXT();
+#else
+    #define OP(name) case H_##name:
+    #define NEXT() continue
+    for (;;) {
+    CHECK_CYCLE()
+    if (executed >= MAX_CYCLES) goto out_of_cycles;
+    d = &decoded[pc];
+    switch (d->handler) {
+#endif
+
+    OP(DECODE) decode_at(pc); NEXT();
+    // TICK() counts the instruction at pc, before a handler moves it
+    OP(NOP)  TICK(); pc = d->next; NEXT();
+    OP(INC)  TICK(); r[d->a]++; pc = d->next; NEXT();
+    OP(DEC)  TICK(); r[d->a]--; pc = d->next; NEXT();
+    OP(ADD)  TICK(); r[d->a] += r[d->b]; pc = d->next; NEXT();
+    OP(SUB)  TICK(); r[d->a] -= r[d->b]; pc = d->next; NEXT();
+    OP(MOV)  TICK(); r[d->a] = r[d->b]; pc = d->next; NEXT();
+    OP(LDI)  TICK(); r[d->a] = d->b; pc = d->next; NEXT();
+    OP(JMP)  TICK(); pc = d->next; NEXT();
+    OP(JZ)   TICK(); pc = (r[0] == 0) ? d->target : d->next; NEXT();
+    OP(PUTC) TICK(); output_buffer.push_back(r[0]); pc = d->next; NEXT();
+    OP(PUTI) {
+        TICK();
+        output_buffer.append_number(r[0]);
+        pc = d->next;
+        NEXT();
+    }
+    OP(LD)   TICK(); r[d->a] = memory[wrap(r[d->b])]; pc = d->next; NEXT();
+    OP(ST) {
+        TICK();
+        size_t addr = wrap(r[d->a]);
+        uint8_t val = r[d->b];
+        pc = d->next;
+        if (memory[addr] != val) {
+            memory[addr] = val;
+            mark_dirty(addr);
+            invalidate_code(addr);
+            writes++;
+        }
+        NEXT();
+    }
+    OP(HLT)  TICK(); pc = d->next; goto out_halted;
+
+#if !GENESIS_COMPUTED_GOTO
+    }
+    }
+#endif
+    #undef OP
+    #undef NEXT
+    #undef CHECK_CYCLE
+    #undef TICK
+
+out_of_cycles:
+    metrics::count_budget_hit();
+    goto out;
+out_halted:
+    metrics::count_halt(executed);
+out:
+    std::memcpy(registers, r, sizeof(r));
+    ip = pc;
+    instructions_executed = executed;
+    halted = true;
+}
+
+template struct BasicVM<0>;   // GenesisVM
+template struct BasicVM<256>; // CellVM
+template struct BasicVM<0, 4, uint16_t>; // GenesisVM16
+template struct BasicVM<0, 4, uint32_t>; // GenesisVM32
@@ -3,7 +3,11 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 #include <string>
+#include <cstring>
+#include <type_traits>
+#include "genome.h"
 
 // Virtual Instruction Set (VIS) Opcodes
 enum OpCode : uint8_t {
@@ -22,31 +26,170 @@ enum OpCode : uint8_t {
     HLT = 0xFF
 };
 
+// Fixed-capacity capture of IO output, so evaluation never allocates.
+// Writes past the capacity are counted in size() but not stored; at the
+// default budget an 8-bit cell prints at most 1000 * 3 digits, which fits.
+struct OutputBuffer {
+    static constexpr size_t CAPACITY = 3072;
+    uint8_t bytes[CAPACITY];
+    size_t length = 0; // Everything written, stored or not
+
+    void clear() { length = 0; }
+    size_t size() const { return length; }
+    size_t stored() const { return length < CAPACITY ? length : CAPACITY; }
+    const uint8_t* data() const { return bytes; }
+    uint8_t operator[](size_t i) const { return bytes[i]; }
+
+    void push_back(uint8_t c) {
+        if (length < CAPACITY) bytes[length] = c;
+        ++length;
+    }
+
+    // Decimal digits of v (IO port 1)
+    void append_number(uint64_t v) {
+        char digits[20];
+        int n = 0;
+        do { digits[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+        while (n) push_back((uint8_t)digits[--n]);
+    }
+
+    // Appends [from, size()) `times` more times
+    void repeat(size_t from, size_t times) {
+        size_t len = length - from;
+        for (size_t t = 0; t < times && length < CAPACITY; ++t) {
+            for (size_t i = 0; i < len && length < CAPACITY; ++i) bytes[length++] = bytes[from + i];
+        }
+        size_t total = from + len * (times + 1); // Whatever did not fit is only counted
+        if (total > length) length = total;
+    }
+
+    bool equals(const std::string& s) const {
+        return length == s.size() && length <= CAPACITY && std::memcmp(bytes, s.data(), length) == 0;
+    }
+    bool contains(const std::string& s) const;
+};
+
 // The Cell: Small, atomic execution environment
-struct GenesisVM {
+//
+// MemSize fixes the memory size at compile time (power-of-two sizes wrap
+// addresses with a mask instead of a modulo); 0 means the size is given to
+// the constructor. NumRegs and Word shape the register file. Word is also
+// the width of ip, of JMP/JZ targets and of LDI immediates, which are
+// stored little-endian in sizeof(Word) bytes.
+template <size_t MemSize, size_t NumRegs = 4, typename Word = uint8_t>
+struct BasicVM {
+    static_assert(std::is_unsigned<Word>::value, "Word must be an unsigned integer type");
+    static_assert(NumRegs >= 1 && NumRegs <= 256, "Register operands are one byte");
+
     uint8_t* memory; // Pointer to memory (can be shared)
     size_t mem_size;
+    size_t mem_mask;  // mem_size - 1 for runtime power-of-two sizes, else 0
     bool owns_memory; // Did we allocate it?
 
-    uint8_t registers[4]; // R0, R1, R2, R3
-    uint8_t ip;           // Instruction Pointer
+    Word registers[NumRegs]; // R0, R1, ...
+    Word ip;                 // Instruction Pointer
     bool halted;
     int instructions_executed;
-    const int MAX_CYCLES = 1000; // Prevent infinite loops
-    std::vector<uint8_t> output_buffer; // New: Capture IO for fitness
+    int MAX_CYCLES = 1000;       // Prevent infinite loops (Arena sets its own budget)
+    bool detect_cycles = false;  // run(): fast-forward once the VM state repeats
+    int cycles_skipped;          // Cycles the detector did not have to execute
+    OutputBuffer output_buffer; // New: Capture IO for fitness
+    // Called after every ST that step() executes, with the wrapped address
+    // (Arena battle recording). run()'s pre-decoded path never calls it.
+    void (*store_hook)(void* context, size_t addr, uint8_t value) = nullptr;
+    void* store_hook_context = nullptr;
+    // Shared-core ownership (Arena territory): step()'s ST marks the cell as
+    // owner_id's and moves it from its old owner's count to owner_id's.
+    // Off while owner_map is nullptr; run()'s pre-decoded path ignores it.
+    uint8_t* owner_map = nullptr;
+    size_t* owner_counts = nullptr; // Cells per owner id, 0 = nobody
+    uint8_t owner_id = 0;
+
+    // Pre-decoded instruction starting at each ip value (run() fast path,
+    // 8-bit words only). Register operands are already reduced and jumps resolved.
+    struct DecodedInsn {
+        uint8_t handler; // 0 = not decoded yet
+        uint8_t a, b;    // Operands
+        uint8_t next;    // ip after the instruction (JMP: its target)
+        uint8_t target;  // JZ: ip when taken
+    };
+    DecodedInsn decoded[sizeof(Word) == 1 ? 256 : 1];
+
+    // Everything run() depends on besides the configuration (MAX_CYCLES,
+    // detect_cycles), for replaying from one point many times
+    struct Snapshot {
+        Word registers[NumRegs];
+        Word ip;
+        bool halted;
+        int instructions_executed;
+        int cycles_skipped;
+        std::vector<uint8_t> memory;
+        std::vector<uint8_t> output; // Stored part of output_buffer
+        size_t output_length;
+    };
 
-    GenesisVM(uint8_t* shared_mem = nullptr, size_t size = 256);
-    ~GenesisVM();
+    // Memory pages written since the last take_snapshot() or restore(), one
+    // bit each. Pages are 16 bytes, or mem_size / 64 if that is larger.
+    uint64_t dirty_pages;
+
+    BasicVM(uint8_t* shared_mem = nullptr, size_t size = MemSize ? MemSize : 256);
+    ~BasicVM();
+
+    BasicVM(const BasicVM&) = delete;
+    BasicVM& operator=(const BasicVM&) = delete;
     
     void reset();
-    void load_program(const std::vector<uint8_t>& program);
+    void load_program(GenomeView program);
     void step();
     void run();
     
     // Helpers
     uint8_t fetch();
+    Word fetch_word();
     void execute(uint8_t opcode);
-    std::string get_output_string();
+    std::string get_output_string(); // Copy of the stored output (not for hot paths)
+
+    // restore() copies back only the pages dirtied since `s` was taken or
+    // last restored; for any other snapshot, or memory shared with other
+    // VMs, it copies all of memory
+    void take_snapshot(Snapshot& s);
+    void restore(const Snapshot& s);
+    // Writes from outside must come through here for restore() to see them
+    void poke(size_t addr, uint8_t value) {
+        addr = wrap(addr);
+        memory[addr] = value;
+        mark_dirty(addr);
+    }
+    void mark_dirty(size_t addr) { dirty_pages |= 1ull << (addr >> page_shift); }
+    void mark_all_dirty() { dirty_pages = page_mask; } // Only the pages memory really has
+
+    size_t wrap(size_t addr) const {
+        if (MemSize != 0 && (MemSize & (MemSize - 1)) == 0) return addr & (MemSize - 1);
+        if (MemSize != 0) return addr % MemSize;
+        if (mem_mask) return addr & mem_mask;
+        return addr % mem_size;
+    }
+    static uint8_t reg(uint8_t operand) { return operand % NumRegs; }
+
+private:
+    unsigned page_shift;
+    uint64_t page_mask; // One bit per page
+    const Snapshot* base_snapshot = nullptr; // What dirty_pages is relative to
+
+    void decode_at(uint8_t pc);
+    void invalidate_code(size_t addr);
+    template <bool DetectCycles> void run_decoded();
+    void repeat_output(size_t from, int times);
 };
 
+// Runtime-sized cell with the original API; memory may be shared (Arena)
+typedef BasicVM<0> GenesisVM;
+
+// Fixed 256-byte cell used by the evolution engine
+typedef BasicVM<256> CellVM;
+
+// Wide-address cores (Arena): ip, registers and immediates of 16/32 bits
+typedef BasicVM<0, 4, uint16_t> GenesisVM16;
+typedef BasicVM<0, 4, uint32_t> GenesisVM32;
+
 #endif